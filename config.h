@@ -39,6 +39,8 @@
 #define CMD_CYCLE_START '~'
 #define CMD_RESET 0x18 // ctrl-x.
 #define CMD_SAFETY_DOOR '@'
+#define CMD_JOG_CANCEL 0x85 // Extended ASCII. Cancels an active $J= jog motion. Ignored otherwise.
+#define CMD_BINARY_STATUS_REPORT 0x86 // Extended ASCII. Requires ENABLE_BINARY_STATUS_REPORT.
 
 // If homing is enabled, homing init lock sets Grbl into an alarm state upon power up. This forces
 // the user to perform the homing cycle (or override the locks) before doing anything else. This is
@@ -96,6 +98,28 @@
 // define to force Grbl to always set the machine origin at the homed location despite switch orientation.
 // #define HOMING_FORCE_SET_ORIGIN // Uncomment to enable.
 
+// Runs every axis of a homing cycle through its own seek, locate, and pull-off phases at the same time,
+// each at its own step rate and acceleration. An axis moves on to its next phase as soon as its own 
+// switch triggers, and the debounce delay only holds that axis, so axes no longer wait on each other 
+// or on a full stepper reset between phases. The homed position is taken from the last switch trigger.
+// During homing, the stepper ISR runs at HOMING_ISR_FREQUENCY and steps each axis from its own rate
+// accumulator. Homing cycles 0, 1, and 2 still run one after another.
+// Homing seek and feed rates ($24,$25) that would step any axis faster than HOMING_ISR_FREQUENCY are 
+// rejected, as are axis steps/mm ($100-$102) that would push the homing rates past it.
+// NOTE: Not supported with COREXY kinematics.
+// #define HOMING_CONCURRENT_AXES // Default disabled. Uncomment to enable.
+#define HOMING_ISR_FREQUENCY 16000 // Stepper ISR rate during homing (Hz). Caps the homing step rate.
+
+// Drives one axis with two motors, each with its own step output and limit switch, as on a gantry 
+// with a motor on each side. Homing stops each side on its own switch, which squares the gantry
+// every time the machine is homed. If one side travels further than DUAL_AXIS_HOMING_FAIL_DISTANCE
+// after the other has found its switch, homing fails, as with a broken switch or jammed side. See
+// cpu_map.h for the pins. On the Uno, these replace M7 mist coolant and the spindle direction (M4).
+// NOTE: Both motors share the axis direction output. Reverse the wiring of a mirrored motor.
+// #define ENABLE_DUAL_AXIS // Default disabled. Uncomment to enable.
+#define DUAL_AXIS_SELECT Y_AXIS // Axis driven by two motors. Typically X_AXIS or Y_AXIS.
+#define DUAL_AXIS_HOMING_FAIL_DISTANCE 5.0 // Maximum squaring travel (mm)
+
 // Number of blocks Grbl executes upon startup. These blocks are stored in EEPROM, where the size
 // and addresses are defined in settings.h. With the current settings, up to 2 startup blocks may
 // be stored and executed in order. These startup blocks would typically be used to set the g-code
@@ -126,14 +150,20 @@
 // #define USE_LINE_NUMBERS // Disabled by default. Uncomment to enable.
 
 // Allows GRBL to report the real-time feed rate.  Enabling this means that GRBL will be reporting more 
-// data with each status update.
-// NOTE: This is experimental and doesn't quite work 100%. Maybe fixed or refactored later.
+// data with each status update. The rate is that of the step segment the stepper ISR is executing,
+// derived from its step timing, so it may be compared against the programmed feed rate.
 // #define REPORT_REALTIME_RATE // Disabled by default. Uncomment to enable.
 
 // Upon a successful probe cycle, this option provides immediately feedback of the probe coordinates
 // through an automatically generated message. If disabled, users can still access the last probe
 // coordinates through Grbl '$#' print parameters.
 #define MESSAGE_PROBE_COORDINATES // Включено по умолчанию. Комментарий для отключения.
+
+// A G38.2-G38.5 probing cycle with an R word runs in two stages without returning to the host. The
+// first stage seeks the probe at the programmed feed rate and retracts by the R distance at rapid
+// rate. The second stage re-probes at the programmed feed rate times this scalar for a precise
+// trigger position.
+#define PROBE_LOCATE_FEED_SCALAR 0.1 // Float (0.0-1.0)
  
 // Enables a second coolant control pin via the mist coolant g-code command M7 on the Arduino Uno
 // analog pin 4. Only use this option if you require a second coolant control pin.
@@ -188,6 +218,25 @@
 // we do not recommend keeping this option enabled. Try to only use this for setting up a new CNC.
 // #define REPORT_CONTROL_PIN_STATE // Default disabled. Uncomment to enable.
 
+// Enables a compact binary status frame, sent in reply to the CMD_BINARY_STATUS_REPORT realtime 
+// command, for hosts polling the status at high rates. The frame has a fixed layout with the machine
+// state, the planner and serial RX buffer counts and the int32 machine step positions. It skips all
+// float formatting and is about a quarter the size of a text report. See report.h for the layout. The
+// host converts steps to positions with the $100-$102 settings and the $# offsets.
+// #define ENABLE_BINARY_STATUS_REPORT // Default disabled. Uncomment to enable.
+
+// Enables firmware performance counters for tuning the planner and streaming, printed by the '$P'
+// command and cleared by '$PC'. Counts planner underruns while more g-code is waiting in the serial
+// buffer, the segment buffer low-water mark while a planner block is queued, the time spent waiting
+// on a full planner, the planner recalculate passes and blocks touched, and the number of blocks with
+// their entry speed limited by the junction deviation. Adds a few bytes of RAM and some flash.
+// #define ENABLE_PERFORMANCE_COUNTERS // Default disabled. Uncomment to enable.
+
+// Adds the '$B' command, which benchmarks the integer-only status report position formatting against 
+// the float formatting at the current machine position. Prints each axis formatted both ways and the
+// microseconds each took, including the step conversion. A development aid. Adds some flash.
+// #define REPORT_FORMAT_BENCHMARK // Default disabled. Uncomment to enable.
+
 // When Grbl powers-cycles or is hard reset with the Arduino reset button, Grbl boots up with no ALARM
 // by default. This is to make it as simple as possible for new users to start using Grbl. When homing
 // is enabled and a user has installed limit switches, Grbl will boot up in an ALARM state to indicate 
@@ -221,6 +270,13 @@
 // step smoothing. See stepper.c for more details on the AMASS system works.
 #define ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING  // Default enabled. Comment to disable.
 
+// Sets the stepper ISR frequency budget for the AMASS settings ($40-$43). Each AMASS level over-drives
+// the stepper ISR by a factor of 2^level for step frequencies below its cutoff, so a level's cutoff
+// frequency multiplied by its overdrive factor must not exceed this value or the setting is rejected.
+// The stock 16kHz budget balances CPU overhead and timer accuracy on a 16MHz AVR. Coarse-step machines
+// may lower the cutoffs to free CPU headroom without reflashing.
+#define AMASS_MAX_ISR_FREQUENCY 16000 // Hz
+
 // Sets the maximum step rate allowed to be written as a Grbl setting. This option enables an error 
 // check in the settings module to prevent settings values that will exceed this limitation. The maximum
 // step rate is strictly limited by the CPU speed and will change if something other than an AVR running
@@ -277,6 +333,8 @@
 // equally divided voltage bins between the maximum and minimum spindle speeds. So for a 5V pin, 1000
 // max rpm, and 250 min rpm, the spindle output voltage would be set for the following "S" commands: 
 // "S1000" @ 5V, "S250" @ 0.02V, and "S625" @ 2.5V (mid-range). The pin outputs 0V when disabled.
+// NOTE: These now only set the default end points of the spindle PWM calibration table ($50-$54 rpm,
+// $60-$64 PWM duty). The defaults map linearly, as above. Enter measured points to linearize a spindle.
 #define SPINDLE_MAX_RPM 1000.0 // Макс. Число оборотов шпинделя. Это значение равно 100% рабочего цикла на ШИМ.
 #define SPINDLE_MIN_RPM 0.0    // Мин. Число оборотов шпинделя. Это значение равно (1/256) скважности на ШИМ.
 
@@ -296,6 +354,19 @@
 // this D13 LED toggling should go away. We haven't tested this though. Please report how it goes!
 // #define USE_SPINDLE_DIR_AS_ENABLE_PIN // Default disabled. Uncomment to enable.
 
+// Enables a spindle index input, one pulse per spindle revolution, for measured spindle speed feedback. 
+// Each pulse is timestamped against the Timer2 tick, and the measured rpm is shown in the status report. 
+// A spindle start or direction change then waits for the measured speed to reach the programmed speed 
+// before any further motion, instead of relying on fixed G4 dwells, and G33 spindle-synchronized motion with a
+// K thread pitch becomes available for threading. The index input is on the control pin port, pin A4 on 
+// the Uno, and shares the control pin change interrupt.
+// NOTE: On the Uno, the index input takes the M7 mist coolant pin, so ENABLE_M7 must be disabled.
+// #define ENABLE_SPINDLE_SYNC // Default disabled. Uncomment to enable.
+#define SPINDLE_INDEX_BIT 4 // Control port bit of the index input. Uno Analog Pin 4.
+#define SPINDLE_AT_SPEED_TOLERANCE 10.0 // Allowed deviation of measured from programmed speed (percent)
+#define SPINDLE_SYNC_TIMEOUT 10000 // Time allowed to reach speed or see an index pulse (milliseconds)
+#define SPINDLE_INDEX_STALE_TIME 6000 // Time without an index pulse to read as stopped, 10rpm (milliseconds)
+
 // With this enabled, Grbl sends back an echo of the line it has received, which has been pre-parsed (spaces
 // removed, capitalized letters, no comments) and is to be immediately executed by Grbl. Echoes will not be 
 // sent upon a line buffer overflow, but should for all normal lines sent to Grbl. For example, if a user 
@@ -335,13 +406,6 @@
 // much greater than this. The default setting should capture most, if not all, full arc error situations.
 #define ARC_ANGULAR_TRAVEL_EPSILON 5E-7 // Float (radians)
 
-// Time delay increments performed during a dwell. The default value is set at 50ms, which provides
-// a maximum time delay of roughly 55 minutes, more than enough for most any application. Increasing
-// this delay will increase the maximum dwell time linearly, but also reduces the responsiveness of 
-// run-time command executions, like status reports, since these are performed between each dwell 
-// time step. Also, keep in mind that the Arduino delay timer is not very accurate for long delays.
-#define DWELL_TIME_STEP 50 // Integer (1-255) (milliseconds)
-
 // Creates a delay between the direction pin setting and corresponding step pulse by creating
 // another interrupt (Timer2 compare) to manage it. The main Grbl interrupt (Timer1 compare) 
 // sets the direction pins, and does not immediately set the stepper pins, as it would in 
@@ -387,6 +451,13 @@
 // NOTE: Значения размера буфера должны быть больше нуля и меньше 256.
 // #define RX_BUFFER_SIZE 128 // Uncomment to override defaults in serial.h
 // #define TX_BUFFER_SIZE 64
+
+// Queues EEPROM writes and programs them in the background from the EEPROM ready interrupt, instead
+// of stalling the main program for about 3.4ms per byte. Writes return immediately while the queue 
+// has space, and realtime commands are executed while waiting on a full queue. Mostly of use with
+// frequent G10 or G28.1/G30.1 updates during a job. Costs 3 bytes of RAM per queue entry.
+// #define ENABLE_EEPROM_WRITE_QUEUE // Default disabled. Uncomment to enable.
+// #define EEPROM_QUEUE_SIZE 16 // Uncomment to override default in eeprom.h. Holds one byte less.
   
 // Toggles XON/XOFF software flow control for serial communications. Not officially supported
 // due to problems involving the Atmega8U2 USB-to-serial chips on current Arduinos. The firmware
@@ -417,6 +488,34 @@
 // NOTE: This option has no effect if SOFTWARE_DEBOUNCE is enabled.
 // #define HARD_LIMIT_FORCE_STATE_CHECK // Default disabled. Uncomment to enable.
 
+// Enables backlash compensation on the controller. When a line motion reverses the direction of an
+// axis with a non-zero backlash setting ($140-$142), mc_line() first plans a short take-up motion of
+// the reversing axes at rapid rate. These take-up motions step the motors only. The g-code parser
+// position and the reported machine and work positions do not include them, so streamed programs
+// need no post-processing. An axis direction is unknown at power-up until the axis has moved once
+// or has been homed, and that first motion is not compensated.
+// NOTE: Not supported with COREXY kinematics.
+// #define ENABLE_BACKLASH_COMPENSATION // Default disabled. Uncomment to enable.
+
+// Enables height map Z compensation, or auto-leveling, for PCB and surface work. The $M=x,y,d,f
+// command probes a grid of HEIGHT_MAP_POINTS_X by HEIGHT_MAP_POINTS_Y points over an x by y area
+// (mm) from the current position. At each point, it probes down up to d (mm) at feed rate f (mm/min)
+// and retracts to the starting height. Line motions then follow the surface. They are split at 
+// the grid cell boundaries, and each end point Z is offset by the bilinear interpolated height,
+// relative to the first probed point. The map is kept in RAM until power-down or $MC clears it.
+// $M prints the map. Outside the probed area, the height at the nearest map edge applies.
+// NOTE: Probe failure alarms as G38.2 does. Each map point takes 4 bytes of RAM.
+// #define ENABLE_HEIGHT_MAP // Default disabled. Uncomment to enable.
+#define HEIGHT_MAP_POINTS_X 5 // Integer (2-255)
+#define HEIGHT_MAP_POINTS_Y 5 // Integer (2-255)
+
+// Bakes a fixed machine profile into the firmware for machines whose settings never change. The step
+// and direction invert masks ($2,$3), the step enable and limit pin inverts ($4,$5) and the homing
+// direction mask ($23) are taken from the selected defaults at compile-time, and writing them returns
+// a setting disabled error. The stepper ISR and homing tests on them become constants, and the axis
+// pin mask lookups are expanded inline. This trades some flash for ISR and planner cycles.
+// #define FIXED_MACHINE_PROFILE // Default disabled. Uncomment to enable.
+
 
 // ---------------------------------------------------------------------------------------
 // COMPILE-TIME ERROR CHECKING OF DEFINE VALUES:
@@ -433,6 +532,31 @@
   #error "USE_SPINDLE_DIR_AS_ENABLE_PIN may only be used with a 328p processor"
 #endif
 
+#if defined(ENABLE_DUAL_AXIS) && (defined(ENABLE_M7) || defined(ENABLE_SPINDLE_SYNC) || defined(USE_SPINDLE_DIR_AS_ENABLE_PIN)) && defined(CPU_MAP_ATMEGA328P)
+  #error "ENABLE_DUAL_AXIS uses the M7, spindle index, and spindle direction pins on a 328p processor"
+#endif
+
+#if defined(ENABLE_DUAL_AXIS) && defined(COREXY)
+  #error "ENABLE_DUAL_AXIS is not supported with COREXY"
+#endif
+
+#if defined(HOMING_CONCURRENT_AXES) && defined(COREXY)
+  #error "HOMING_CONCURRENT_AXES is not supported with COREXY"
+#endif
+
+#if defined(ENABLE_BACKLASH_COMPENSATION) && defined(COREXY)
+  #error "ENABLE_BACKLASH_COMPENSATION is not supported with COREXY"
+#endif
+
+#if defined(ENABLE_SPINDLE_SYNC) && defined(ENABLE_M7) && defined(CPU_MAP_ATMEGA328P)
+  #error "ENABLE_SPINDLE_SYNC uses the M7 mist coolant pin on a 328p processor"
+#endif
+
+#if defined(ENABLE_HEIGHT_MAP) && ((HEIGHT_MAP_POINTS_X < 2) || (HEIGHT_MAP_POINTS_Y < 2))
+  #error "HEIGHT_MAP_POINTS_X and HEIGHT_MAP_POINTS_Y must be at least 2"
+#endif
+
+
 // ---------------------------------------------------------------------------------------
 
 
@@ -6,12 +6,18 @@
 #include "grbl.h"
 
 
+uint8_t coolant_programmed;
+static uint8_t coolant_applied; // Last set outputs. Restored after a safety door stop.
+
+
 void coolant_init()
 {
   COOLANT_FLOOD_DDR |= (1 << COOLANT_FLOOD_BIT);
   #ifdef ENABLE_M7
     COOLANT_MIST_DDR |= (1 << COOLANT_MIST_BIT);
   #endif
+  coolant_programmed = COOLANT_DISABLE;
+  coolant_applied = COOLANT_DISABLE;
   coolant_stop();
 }
 
@@ -41,9 +47,32 @@ void coolant_set_state(uint8_t mode)
 }
 
 
+void coolant_set_output(uint8_t coolant_mask)
+{
+  coolant_applied = coolant_mask;
+  if (coolant_mask & COOLANT_FLOOD_ENABLE) { COOLANT_FLOOD_PORT |= (1 << COOLANT_FLOOD_BIT); }
+  else { COOLANT_FLOOD_PORT &= ~(1 << COOLANT_FLOOD_BIT); }
+  #ifdef ENABLE_M7
+    if (coolant_mask & COOLANT_MIST_ENABLE) { COOLANT_MIST_PORT |= (1 << COOLANT_MIST_BIT); }
+    else { COOLANT_MIST_PORT &= ~(1 << COOLANT_MIST_BIT); }
+  #endif
+}
+
+
+uint8_t coolant_restore()
+{
+  coolant_set_output(coolant_applied);
+  return(coolant_applied != COOLANT_DISABLE);
+}
+
+
 void coolant_run(uint8_t mode)
 {
   if (sys.state == STATE_CHECK_MODE) { return; }
-  protocol_buffer_synchronize(); // Ensure coolant turns on when specified in program.  
-  coolant_set_state(mode);
+  // Update the programmed coolant outputs, which are carried by every block planned from here on. 
+  // M7 and M8 may both be active. Only M9 turns coolant off.
+  if (mode == COOLANT_DISABLE) { coolant_programmed = COOLANT_DISABLE; }
+  else { coolant_programmed |= mode; }
+  // Apply now, if there are no motions to order it against. See spindle_run().
+  if ((sys.state == STATE_IDLE) && (plan_get_current_block() == NULL) && !sys.delay) { coolant_set_output(coolant_programmed); }
 }
@@ -6,9 +6,19 @@
 #define coolant_control_h 
 
 
+// Programmed coolant outputs as a bitmask of COOLANT_MIST_ENABLE and COOLANT_FLOOD_ENABLE. Updated
+// in g-code program order by coolant_run() and carried by each planner block.
+extern uint8_t coolant_programmed;
+
 void coolant_init();
 void coolant_stop();
 void coolant_set_state(uint8_t mode);
 void coolant_run(uint8_t mode);
 
+// Immediately sets the coolant outputs from a bitmask. Called by the stepper ISR at a new block.
+void coolant_set_output(uint8_t coolant_mask);
+
+// Re-applies the last set coolant outputs after a coolant stop. Returns true if any are enabled.
+uint8_t coolant_restore();
+
 #endif
\ No newline at end of file
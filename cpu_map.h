@@ -37,6 +37,23 @@
   #include "cpu_map/cpu_map_atmega2560.h"
 #endif
 
+// Dual axis pins. The second motor of the dual axis has its own step output and limit switch input,
+// and shares the direction output of its axis. On the Uno, the step output takes the M7 mist coolant 
+// pin (A4) and the limit input takes the spindle direction pin (D13), which is on the limit pin change
+// port, so hard limits cover both switches. Other pin maps must define these to use ENABLE_DUAL_AXIS.
+#ifdef ENABLE_DUAL_AXIS
+  #ifdef CPU_MAP_ATMEGA328P
+    #define DUAL_STEP_DDR  DDRC
+    #define DUAL_STEP_PORT PORTC
+    #define DUAL_STEP_BIT  4 // Uno Analog Pin 4
+    #define DUAL_LIMIT_BIT 5 // Uno Digital Pin 13. Must be on the limit port.
+    #define DISABLE_SPINDLE_DIRECTION_PIN // No M4. Pin taken by the dual limit input.
+  #endif
+  #if !defined(DUAL_STEP_BIT) || !defined(DUAL_LIMIT_BIT)
+    #error "ENABLE_DUAL_AXIS requires dual axis pins in the cpu map"
+  #endif
+#endif
+
 /* 
 #ifdef CPU_MAP_CUSTOM_PROC
   // For a custom pin map or different processor, copy and edit one of the available cpu
@@ -73,4 +73,33 @@
   #include "defaults/defaults_simulator.h"
 #endif
 
+// Defaults for settings not specified by the selected machine defaults file above.
+#ifndef DEFAULT_AMASS_MAX_LEVEL
+  #define DEFAULT_AMASS_MAX_LEVEL 3 // Number of enabled AMASS levels (0-3)
+#endif
+#ifndef DEFAULT_AMASS_LEVEL1_CUTOFF
+  #define DEFAULT_AMASS_LEVEL1_CUTOFF 8000 // Hz. Over-drives ISR (x2)
+#endif
+#ifndef DEFAULT_AMASS_LEVEL2_CUTOFF
+  #define DEFAULT_AMASS_LEVEL2_CUTOFF 4000 // Hz. Over-drives ISR (x4)
+#endif
+#ifndef DEFAULT_AMASS_LEVEL3_CUTOFF
+  #define DEFAULT_AMASS_LEVEL3_CUTOFF 2000 // Hz. Over-drives ISR (x8)
+#endif
+#ifndef DEFAULT_LASER_MODE
+  #define DEFAULT_LASER_MODE 0 // false
+#endif
+#ifndef DEFAULT_STATUS_PUSH_INTERVAL
+  #define DEFAULT_STATUS_PUSH_INTERVAL 0 // msec (0-65535). Disabled.
+#endif
+#ifndef DEFAULT_X_BACKLASH
+  #define DEFAULT_X_BACKLASH 0.0 // mm
+#endif
+#ifndef DEFAULT_Y_BACKLASH
+  #define DEFAULT_Y_BACKLASH 0.0 // mm
+#endif
+#ifndef DEFAULT_Z_BACKLASH
+  #define DEFAULT_Z_BACKLASH 0.0 // mm
+#endif
+
 #endif
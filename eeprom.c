@@ -23,6 +23,8 @@
 ****************************************************************************/
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/crc16.h>
+#include "grbl.h"
 
 /* These EEPROM bits have different names on different devices. */
 #ifndef EEPE
@@ -37,6 +39,18 @@
 /* Define to reduce code size. */
 #define EEPROM_IGNORE_SELFPROG //!< Remove SPM flag polling.
 
+#ifdef ENABLE_EEPROM_WRITE_QUEUE
+/* Write queue drained in the background by the EEPROM ready interrupt. */
+static unsigned int eeprom_queue_addr[EEPROM_QUEUE_SIZE];
+static unsigned char eeprom_queue_data[EEPROM_QUEUE_SIZE];
+static unsigned char eeprom_queue_head = 0;
+static volatile unsigned char eeprom_queue_tail = 0;
+
+#define EEPROM_READY_INT (1<<EERIE) //!< Kept enabled while programming from the queue.
+#else
+#define EEPROM_READY_INT 0
+#endif
+
 /*! \brief  Read byte from EEPROM.
  *
  *  This function reads one byte from a given EEPROM address.
@@ -48,43 +62,40 @@
  */
 unsigned char eeprom_get_char( unsigned int addr )
 {
+	#ifdef ENABLE_EEPROM_WRITE_QUEUE
+	eeprom_flush(); // Wait until all queued writes have been programmed.
+	#endif
 	do {} while( EECR & (1<<EEPE) ); // Wait for completion of previous write.
 	EEAR = addr; // Set EEPROM address register.
 	EECR = (1<<EERE); // Start EEPROM read operation.
 	return EEDR; // Return the byte read from EEPROM.
 }
 
-/*! \brief  Write byte to EEPROM.
+/*! \brief  Program byte to EEPROM.
  *
- *  This function writes one byte to a given EEPROM address.
+ *  This function programs one byte to a given EEPROM address.
  *  The differences between the existing byte and the new value is used
  *  to select the most efficient EEPROM programming mode.
  *
- *  \note  The CPU is halted for 2 clock cycles during EEPROM programming.
- *
- *  \note  When this function returns, the new EEPROM value is not available
- *         until the EEPROM programming time has passed. The EEPE bit in EECR
- *         should be polled to check whether the programming is finished.
- *
- *  \note  The EEPROM_GetChar() function checks the EEPE bit automatically.
+ *  \note  Called with interrupts disabled and no write in progress, i.e.
+ *         from the EEPROM ready interrupt, or from eeprom_wait() at power
+ *         up. The EEPROM ready interrupt is kept enabled for the next byte.
+ *         Without the write queue, called from eeprom_put_char().
  *
  *  \param  addr  EEPROM address to write to.
  *  \param  new_value  New EEPROM value.
  */
-void eeprom_put_char( unsigned int addr, unsigned char new_value )
+static void eeprom_program_char( unsigned int addr, unsigned char new_value )
 {
 	char old_value; // Old EEPROM value.
 	char diff_mask; // Difference mask, i.e. old value XOR new value.
 
-	cli(); // Ensure atomic operation for the write operation.
-	
-	do {} while( EECR & (1<<EEPE) ); // Wait for completion of previous write.
 	#ifndef EEPROM_IGNORE_SELFPROG
 	do {} while( SPMCSR & (1<<SELFPRGEN) ); // Wait for completion of SPM.
 	#endif
 	
 	EEAR = addr; // Set EEPROM address register.
-	EECR = (1<<EERE); // Start EEPROM read operation.
+	EECR = EEPROM_READY_INT | (1<<EERE); // Start EEPROM read operation.
 	old_value = EEDR; // Get old EEPROM value.
 	diff_mask = old_value ^ new_value; // Get bit differences.
 	
@@ -97,13 +108,13 @@ void eeprom_put_char( unsigned int addr, unsigned char new_value )
 			// Now we know that some bits need to be programmed to '0' also.
 			
 			EEDR = new_value; // Set EEPROM data register.
-			EECR = (1<<EEMPE) | // Set Master Write Enable bit...
+			EECR = EEPROM_READY_INT | (1<<EEMPE) | // Set Master Write Enable bit...
 			       (0<<EEPM1) | (0<<EEPM0); // ...and Erase+Write mode.
 			EECR |= (1<<EEPE);  // Start Erase+Write operation.
 		} else {
 			// Now we know that all bits should be erased.
 
-			EECR = (1<<EEMPE) | // Set Master Write Enable bit...
+			EECR = EEPROM_READY_INT | (1<<EEMPE) | // Set Master Write Enable bit...
 			       (1<<EEPM0);  // ...and Erase-only mode.
 			EECR |= (1<<EEPE);  // Start Erase-only operation.
 		}
@@ -115,37 +126,157 @@ void eeprom_put_char( unsigned int addr, unsigned char new_value )
 			// Now we know that _some_ bits need to the programmed to '0'.
 			
 			EEDR = new_value;   // Set EEPROM data register.
-			EECR = (1<<EEMPE) | // Set Master Write Enable bit...
+			EECR = EEPROM_READY_INT | (1<<EEMPE) | // Set Master Write Enable bit...
 			       (1<<EEPM1);  // ...and Write-only mode.
 			EECR |= (1<<EEPE);  // Start Write-only operation.
 		}
 	}
-	
-	sei(); // Restore interrupt flag state.
 }
 
+#ifdef ENABLE_EEPROM_WRITE_QUEUE
+/*! \brief  Program the next queued byte.
+ *
+ *  Programs the byte at the queue tail, or disables the EEPROM ready
+ *  interrupt once the queue is empty. No write may be in progress.
+ */
+static void eeprom_program_next( void )
+{
+	unsigned char tail = eeprom_queue_tail; // Temporary eeprom_queue_tail (to optimize for volatile)
+	if( tail == eeprom_queue_head ) {
+		EECR &= ~(1<<EERIE); // Queue empty. Disable EEPROM ready interrupt.
+		return;
+	}
+	eeprom_program_char( eeprom_queue_addr[tail], eeprom_queue_data[tail] );
+
+	// Update tail position
+	tail++;
+	if( tail == EEPROM_QUEUE_SIZE ) { tail = 0; }
+	eeprom_queue_tail = tail;
+}
+
+/*! \brief  Wait for the write queue to drain by one byte.
+ *
+ *  With interrupts enabled, the queue drains in the background, so realtime
+ *  commands keep executing while waiting. A settings write queues a few
+ *  hundred bytes and takes about a second to program. Before interrupts are
+ *  enabled at power up, the byte is programmed directly instead.
+ *
+ *  \note  Never called from an interrupt.
+ */
+static void eeprom_wait( void )
+{
+	if( SREG & (1<<SREG_I) ) {
+		protocol_execute_realtime();
+	} else {
+		do {} while( EECR & (1<<EEPE) ); // Wait for completion of previous write.
+		eeprom_program_next();
+	}
+}
+
+/*! \brief  Write byte to EEPROM.
+ *
+ *  This function queues one byte for a given EEPROM address and returns
+ *  without waiting for the EEPROM programming time. The queue is drained
+ *  in the background by the EEPROM ready interrupt.
+ *
+ *  \note  Only blocks while the queue is full. Realtime commands are
+ *         executed meanwhile, see eeprom_wait().
+ *
+ *  \note  The EEPROM_GetChar() function waits for the queue automatically.
+ *
+ *  \param  addr  EEPROM address to write to.
+ *  \param  new_value  New EEPROM value.
+ */
+void eeprom_put_char( unsigned int addr, unsigned char new_value )
+{
+	// Calculate next head
+	unsigned char next_head = eeprom_queue_head + 1;
+	if( next_head == EEPROM_QUEUE_SIZE ) { next_head = 0; }
+
+	// Wait until there is space in the queue
+	while( next_head == eeprom_queue_tail ) { eeprom_wait(); }
+
+	// Store byte and advance head
+	eeprom_queue_addr[eeprom_queue_head] = addr;
+	eeprom_queue_data[eeprom_queue_head] = new_value;
+	eeprom_queue_head = next_head;
+
+	// Enable EEPROM ready interrupt to make sure the queue is being drained.
+	EECR |= (1<<EERIE);
+}
+
+/*! \brief  Wait for all queued EEPROM writes.
+ *
+ *  This function returns once the write queue is empty. The last byte may
+ *  still be programming, which is checked by polling the EEPE bit.
+ */
+void eeprom_flush( void )
+{
+	while( eeprom_queue_tail != eeprom_queue_head ) { eeprom_wait(); }
+}
+
+/*! \brief  EEPROM ready interrupt.
+ *
+ *  Fires while the EEPROM is ready for a new write. Programs the next queued
+ *  byte, or disables itself once the queue is empty.
+ */
+ISR(EE_READY_vect)
+{
+	eeprom_program_next();
+}
+#else
+/*! \brief  Write byte to EEPROM.
+ *
+ *  This function programs one byte to a given EEPROM address, after
+ *  waiting for the previous write to complete.
+ *
+ *  \note  Blocks for up to 3.4ms per byte. Interrupts are disabled only
+ *         for the timed write sequence.
+ *
+ *  \param  addr  EEPROM address to write to.
+ *  \param  new_value  New EEPROM value.
+ */
+void eeprom_put_char( unsigned int addr, unsigned char new_value )
+{
+	do {} while( EECR & (1<<EEPE) ); // Wait for completion of previous write.
+	unsigned char sreg = SREG;
+	cli(); // Ensure atomic operation for the write operation.
+	eeprom_program_char( addr, new_value );
+	SREG = sreg; // Restore interrupt flag state.
+}
+
+/*! \brief  Wait for the last EEPROM write to complete.
+ */
+void eeprom_flush( void )
+{
+	do {} while( EECR & (1<<EEPE) ); // Wait for completion of previous write.
+}
+#endif
+
 // Extensions added as part of Grbl 
 
 
+// Records are protected by a CRC-16 (CCITT), stored low byte first after the data.
 void memcpy_to_eeprom_with_checksum(unsigned int destination, char *source, unsigned int size) {
-  unsigned char checksum = 0;
+  unsigned int checksum = 0xffff;
   for(; size > 0; size--) { 
-    checksum = (checksum << 1) || (checksum >> 7);
-    checksum += *source;
+    checksum = _crc_ccitt_update(checksum, *source);
     eeprom_put_char(destination++, *(source++)); 
   }
-  eeprom_put_char(destination, checksum);
+  eeprom_put_char(destination++, checksum & 0xff);
+  eeprom_put_char(destination, checksum >> 8);
 }
 
 int memcpy_from_eeprom_with_checksum(char *destination, unsigned int source, unsigned int size) {
-  unsigned char data, checksum = 0;
+  unsigned char data;
+  unsigned int checksum = 0xffff;
   for(; size > 0; size--) { 
     data = eeprom_get_char(source++);
-    checksum = (checksum << 1) || (checksum >> 7);
-    checksum += data;    
+    checksum = _crc_ccitt_update(checksum, data);
     *(destination++) = data; 
   }
-  return(checksum == eeprom_get_char(source));
+  if (eeprom_get_char(source++) != (checksum & 0xff)) { return(0); }
+  return(eeprom_get_char(source) == (checksum >> 8));
 }
 
 // end of file
@@ -5,8 +5,26 @@
 #ifndef eeprom_h
 #define eeprom_h
 
+// Size of the EEPROM write queue, when enabled. See ENABLE_EEPROM_WRITE_QUEUE in config.h. Writes 
+// return immediately while the queue has space and are programmed in the background by the EEPROM
+// ready interrupt, at about 3.4ms per byte. 
+// NOTE: Larger writes still block until their last bytes fit, about a second for a '$x=' setting,
+// but realtime commands are executed while waiting.
+#ifdef ENABLE_EEPROM_WRITE_QUEUE
+  #ifndef EEPROM_QUEUE_SIZE
+    #define EEPROM_QUEUE_SIZE 16
+  #endif
+  #if (EEPROM_QUEUE_SIZE < 2) || (EEPROM_QUEUE_SIZE > 255)
+    #error "EEPROM_QUEUE_SIZE must be 2 to 255, for the 8-bit queue indices."
+  #endif
+#endif
+
+// Size of the CRC-16 stored after each record written with checksum.
+#define EEPROM_CHECKSUM_SIZE 2
+
 unsigned char eeprom_get_char(unsigned int addr);
 void eeprom_put_char(unsigned int addr, unsigned char new_value);
+void eeprom_flush();
 void memcpy_to_eeprom_with_checksum(unsigned int destination, char *source, unsigned int size);
 int memcpy_from_eeprom_with_checksum(char *destination, unsigned int source, unsigned int size);
 
@@ -35,6 +35,23 @@ void gc_init()
   if (!(settings_read_coord_data(gc_state.modal.coord_select,gc_state.coord_system))) { 
     report_status_message(STATUS_SETTING_READ_FAIL); 
   } 
+  gc_update_work_offset();
+}
+
+
+// Converts the total work offset of each axis, the coordinate system plus G92 offset plus tool length 
+// offset, to the reported units of the last printed digit in 24.8 fixed-point. This keeps the float math
+// out of the WPos status report, which only subtracts it. Called whenever an offset or $13 changes.
+// NOTE: 24 integer bits span over 8m in mm mode and 800in in inch mode, beyond any real work offset.
+void gc_update_work_offset()
+{
+  uint8_t idx;
+  float offset;
+  for (idx=0; idx<N_AXIS; idx++) {
+    offset = gc_state.coord_system[idx]+gc_state.coord_offset[idx];
+    if (idx == TOOL_LENGTH_OFFSET_AXIS) { offset += gc_state.tool_length_offset; }
+    gc_state.work_offset[idx] = lround(offset*settings_inverse.coord_units_per_mm*256.0);
+  }
 }
 
 
@@ -44,6 +61,7 @@ void gc_init()
 void gc_sync_position() 
 {
   system_convert_array_steps_to_mpos(gc_state.position,sys.position);
+  mc_uncompensate_position(gc_state.position);
 }
 
 
@@ -105,6 +123,16 @@ uint8_t gc_execute_line(char *line)
   uint8_t int_value = 0;
   uint16_t mantissa = 0;
 
+  // A '$J=' jog line is parsed as a linear motion block in units per minute feed rate mode. Only
+  // the units, distance mode, and G53 words are accepted. See jog error-checking below.
+  uint8_t is_jog_motion = false;
+  if (line[0] == '$') {
+    char_counter = 3; // Skip '$J='
+    is_jog_motion = true;
+    gc_block.modal.motion = MOTION_MODE_LINEAR;
+    gc_block.modal.feed_rate = FEED_RATE_MODE_UNITS_PER_MIN;
+  }
+
   while (line[char_counter] != 0) { // Loop until no more g-code words in line.
     
     // Import the next g-code word, expecting a letter followed by a value. Otherwise, error out.
@@ -174,6 +202,9 @@ uint8_t gc_execute_line(char *line)
                 break;      
             }
             break;
+          #ifdef ENABLE_SPINDLE_SYNC
+            case 33:
+          #endif
           case 0: case 1: case 2: case 3: case 38: 
             // Check for G0/1/2/3/38 being called with G10/28/30/92 on same block.
             // * G43.1 is also an axis command but is not explicitly defined this way.
@@ -197,6 +228,9 @@ uint8_t gc_execute_line(char *line)
                 }
                 mantissa = 0; // Set to zero to indicate valid non-integer G command.
                 break;
+              #ifdef ENABLE_SPINDLE_SYNC
+                case 33: gc_block.modal.motion = MOTION_MODE_SPINDLE_SYNC; break; // G33
+              #endif
               case 80: gc_block.modal.motion = MOTION_MODE_NONE; break; // G80
             }            
             break;
@@ -282,14 +316,14 @@ uint8_t gc_execute_line(char *line)
               case 2: case 30: gc_block.modal.program_flow = PROGRAM_FLOW_COMPLETED; break; // Program end and reset 
             }
             break;
-          #ifndef USE_SPINDLE_DIR_AS_ENABLE_PIN
+          #if !defined(USE_SPINDLE_DIR_AS_ENABLE_PIN) && !defined(DISABLE_SPINDLE_DIRECTION_PIN)
             case 4: 
           #endif
           case 3: case 5:
             word_bit = MODAL_GROUP_M7; 
             switch(int_value) {
               case 3: gc_block.modal.spindle = SPINDLE_ENABLE_CW; break;
-              #ifndef USE_SPINDLE_DIR_AS_ENABLE_PIN
+              #if !defined(USE_SPINDLE_DIR_AS_ENABLE_PIN) && !defined(DISABLE_SPINDLE_DIRECTION_PIN)
                 case 4: gc_block.modal.spindle = SPINDLE_ENABLE_CCW; break;
               #endif
               case 5: gc_block.modal.spindle = SPINDLE_DISABLE; break;
@@ -427,7 +461,11 @@ uint8_t gc_execute_line(char *line)
   // [2. Set feed rate mode ]: G93 F word missing with G1,G2/3 active, implicitly or explicitly. Feed rate
   //   is not defined after switching to G94 from G93.
   
-  if (gc_block.modal.feed_rate == FEED_RATE_MODE_INVERSE_TIME) { // = G93
+  if (is_jog_motion) {
+    // [Jog Errors]: F word missing. A jog never uses or alters the modal feed rate.
+    if (bit_isfalse(value_words,bit(WORD_F))) { FAIL(STATUS_GCODE_UNDEFINED_FEED_RATE); } // [F word missing]
+    if (gc_block.modal.units == UNITS_MODE_INCHES) { gc_block.values.f *= MM_PER_INCH; }
+  } else if (gc_block.modal.feed_rate == FEED_RATE_MODE_INVERSE_TIME) { // = G93
     // NOTE: G38 can also operate in inverse time, but is undefined as an error. Missing F word check added here.
     if (axis_command == AXIS_COMMAND_MOTION_MODE) { 
       if ((gc_block.modal.motion != MOTION_MODE_NONE) || (gc_block.modal.motion != MOTION_MODE_SEEK)) {
@@ -670,6 +708,19 @@ uint8_t gc_execute_line(char *line)
       // Axis words are optional. If missing, set axis command flag to ignore execution.
       if (!axis_words) { axis_command = AXIS_COMMAND_NONE; }
 
+    #ifdef ENABLE_SPINDLE_SYNC
+    // [G33 Errors]: K thread pitch missing or not positive. No axis words. Inverse time mode. Spindle is
+    //   not enabled. NOTE: The feed rate follows from the pitch and measured spindle speed. F is not used.
+    } else if (gc_block.modal.motion == MOTION_MODE_SPINDLE_SYNC) {
+      if (bit_isfalse(value_words,bit(WORD_K))) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [K word missing]
+      if (gc_block.values.ijk[Z_AXIS] <= 0.0) { FAIL(STATUS_NEGATIVE_VALUE); } // [Pitch not positive]
+      if (gc_block.modal.units == UNITS_MODE_INCHES) { gc_block.values.ijk[Z_AXIS] *= MM_PER_INCH; }
+      bit_false(value_words,bit(WORD_K));
+      if (!axis_words) { FAIL(STATUS_GCODE_NO_AXIS_WORDS); } // [No axis words]
+      if (gc_block.modal.feed_rate == FEED_RATE_MODE_INVERSE_TIME) { FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); } // [G93 not supported]
+      if (gc_block.modal.spindle == SPINDLE_DISABLE) { FAIL(STATUS_GCODE_SPINDLE_NOT_RUNNING); } // [Spindle off]
+    #endif
+
     // All remaining motion modes (all but G0 and G80), require a valid feed rate value. In units per mm mode,
     // the value must be positive. In inverse time mode, a positive value must be passed with each block.
     } else {      
@@ -826,6 +877,12 @@ uint8_t gc_execute_line(char *line)
           //   allow the planner buffer to empty and move off the probe trigger before another probing cycle.
           if (!axis_words) { FAIL(STATUS_GCODE_NO_AXIS_WORDS); } // [No axis words]
           if (gc_check_same_position(gc_state.position, gc_block.values.xyz)) { FAIL(STATUS_GCODE_INVALID_TARGET); } // [Invalid target]
+          // An R word sets the retract distance of a two-stage probing cycle. Otherwise, it is zero.
+          if (bit_istrue(value_words,bit(WORD_R))) {
+            bit_false(value_words,bit(WORD_R));
+            if (gc_block.values.r < 0.0) { FAIL(STATUS_NEGATIVE_VALUE); } // [R retract negative]
+            if (gc_block.modal.units == UNITS_MODE_INCHES) { gc_block.values.r *= MM_PER_INCH; }
+          }
           break;
       } 
     }
@@ -833,12 +890,34 @@ uint8_t gc_execute_line(char *line)
   
   // [21. Program flow ]: No error checks required.
 
+  // [Jog Errors]: Any command other than G20/21, G90/91, or G53. Spindle or tool words. No axis words.
+  if (is_jog_motion) {
+    if (command_words & ~(bit(MODAL_GROUP_G0)|bit(MODAL_GROUP_G3)|bit(MODAL_GROUP_G6))) { FAIL(STATUS_INVALID_JOG_COMMAND); }
+    if (!(gc_block.non_modal_command == NON_MODAL_NO_ACTION || gc_block.non_modal_command == NON_MODAL_ABSOLUTE_OVERRIDE)) { 
+      FAIL(STATUS_INVALID_JOG_COMMAND); 
+    }
+    if (bit_istrue(value_words,(bit(WORD_S)|bit(WORD_T)))) { FAIL(STATUS_INVALID_JOG_COMMAND); }
+    if (!axis_words) { FAIL(STATUS_GCODE_NO_AXIS_WORDS); } // [No axis words]
+  }
+
   // [0. Non-specific error-checks]: Complete unused value words check, i.e. IJK used when in arc
   // radius mode, or axis words that aren't used in the block.  
   bit_false(value_words,(bit(WORD_N)|bit(WORD_F)|bit(WORD_S)|bit(WORD_T))); // Remove single-meaning value words. 
   if (axis_command) { bit_false(value_words,(bit(WORD_X)|bit(WORD_Y)|bit(WORD_Z))); } // Remove axis words. 
   if (value_words) { FAIL(STATUS_GCODE_UNUSED_WORDS); } // [Unused words]
 
+  // Execute a jog and return. The jog only updates the parser position. Its distance and units 
+  // words apply to this block alone and are not retained in the modal state.
+  if (is_jog_motion) {
+    #ifdef USE_LINE_NUMBERS
+      uint8_t status_code = mc_jog_execute(gc_block.values.xyz, gc_block.values.f, gc_block.values.n);
+    #else
+      uint8_t status_code = mc_jog_execute(gc_block.values.xyz, gc_block.values.f);
+    #endif
+    if (status_code == STATUS_OK) { memcpy(gc_state.position, gc_block.values.xyz, sizeof(gc_block.values.xyz)); }
+    return(status_code);
+  }
+
    
   /* -------------------------------------------------------------------------------------
      STEP 4: EXECUTE!!
@@ -907,12 +986,14 @@ uint8_t gc_execute_line(char *line)
     } else { // G49
       gc_state.tool_length_offset = 0.0;
     }
+    gc_update_work_offset();
   }
   
   // [15. Coordinate system selection ]:
   if (gc_state.modal.coord_select != gc_block.modal.coord_select) {
     gc_state.modal.coord_select = gc_block.modal.coord_select;
     memcpy(gc_state.coord_system,coordinate_data,sizeof(coordinate_data));
+    gc_update_work_offset();
   }
   
   // [16. Set path control mode ]: G61.1/G64 NOT SUPPORTED
@@ -928,11 +1009,15 @@ uint8_t gc_execute_line(char *line)
     case NON_MODAL_SET_COORDINATE_DATA:    
       settings_write_coord_data(coord_select,parameter_data);
       // Update system coordinate system if currently active.
-      if (gc_state.modal.coord_select == coord_select) { memcpy(gc_state.coord_system,parameter_data,sizeof(parameter_data)); }
+      if (gc_state.modal.coord_select == coord_select) { 
+        memcpy(gc_state.coord_system,parameter_data,sizeof(parameter_data)); 
+        gc_update_work_offset();
+      }
       break;
     case NON_MODAL_GO_HOME_0: case NON_MODAL_GO_HOME_1: 
       // Move to intermediate position before going home. Obeys current coordinate system and offsets 
       // and absolute and incremental modes.
+      plan_set_program_motion(true);
       if (axis_command) {
         #ifdef USE_LINE_NUMBERS
           mc_line(gc_block.values.xyz, -1.0, false, gc_state.line_number);
@@ -945,6 +1030,7 @@ uint8_t gc_execute_line(char *line)
       #else
         mc_line(parameter_data, -1.0, false); 
       #endif
+      plan_set_program_motion(false);
       memcpy(gc_state.position, parameter_data, sizeof(parameter_data));
       break;
     case NON_MODAL_SET_HOME_0: 
@@ -955,9 +1041,11 @@ uint8_t gc_execute_line(char *line)
       break;
     case NON_MODAL_SET_COORDINATE_OFFSET:
       memcpy(gc_state.coord_offset,gc_block.values.xyz,sizeof(gc_block.values.xyz));
+      gc_update_work_offset();
       break;
     case NON_MODAL_RESET_COORDINATE_OFFSET: 
       clear_vector(gc_state.coord_offset); // Disable G92 offsets by zeroing offset vector.
+      gc_update_work_offset();
       break;
   }
 
@@ -968,6 +1056,10 @@ uint8_t gc_execute_line(char *line)
   gc_state.modal.motion = gc_block.modal.motion;
   if (gc_state.modal.motion != MOTION_MODE_NONE) {
     if (axis_command == AXIS_COMMAND_MOTION_MODE) {
+      // Feed, rapid, arc, and G33 motions carry the programmed spindle and coolant outputs. Probing
+      // cycles are system motions, which start from a drained buffer with the outputs already set.
+      plan_set_program_motion((gc_state.modal.motion < MOTION_MODE_PROBE_TOWARD) || 
+                              (gc_state.modal.motion == MOTION_MODE_SPINDLE_SYNC));
       switch (gc_state.modal.motion) {
         case MOTION_MODE_SEEK:
           #ifdef USE_LINE_NUMBERS
@@ -1001,36 +1093,47 @@ uint8_t gc_execute_line(char *line)
               gc_state.feed_rate, gc_state.modal.feed_rate, axis_0, axis_1, axis_linear, false); 
           #endif
           break;
+        #ifdef ENABLE_SPINDLE_SYNC
+          case MOTION_MODE_SPINDLE_SYNC:
+            // NOTE: gc_block.values.xyz is returned with the current position, if the motion never started.
+            #ifdef USE_LINE_NUMBERS
+              mc_spindle_sync_line(gc_block.values.xyz, gc_block.values.ijk[Z_AXIS], gc_state.line_number);
+            #else
+              mc_spindle_sync_line(gc_block.values.xyz, gc_block.values.ijk[Z_AXIS]);
+            #endif
+            break;
+        #endif
         case MOTION_MODE_PROBE_TOWARD: 
           // NOTE: gc_block.values.xyz is returned from mc_probe_cycle with the updated position value. So
           // upon a successful probing cycle, the machine position and the returned value should be the same.
           #ifdef USE_LINE_NUMBERS
-            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, false, false, gc_state.line_number);
+            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, gc_block.values.r, false, false, gc_state.line_number);
           #else
-            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, false, false);
+            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, gc_block.values.r, false, false);
           #endif
           break;
         case MOTION_MODE_PROBE_TOWARD_NO_ERROR:
           #ifdef USE_LINE_NUMBERS
-            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, false, true, gc_state.line_number);
+            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, gc_block.values.r, false, true, gc_state.line_number);
           #else
-            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, false, true);
+            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, gc_block.values.r, false, true);
           #endif
           break;
         case MOTION_MODE_PROBE_AWAY:
           #ifdef USE_LINE_NUMBERS
-            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, true, false, gc_state.line_number);
+            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, gc_block.values.r, true, false, gc_state.line_number);
           #else
-            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, true, false);
+            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, gc_block.values.r, true, false);
           #endif
           break;
         case MOTION_MODE_PROBE_AWAY_NO_ERROR:
           #ifdef USE_LINE_NUMBERS
-            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, true, true, gc_state.line_number);
+            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, gc_block.values.r, true, true, gc_state.line_number);
           #else        
-            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, true, true);
+            mc_probe_cycle(gc_block.values.xyz, gc_state.feed_rate, gc_state.modal.feed_rate, gc_block.values.r, true, true);
           #endif
       }
+      plan_set_program_motion(false);
     
       // As far as the parser is concerned, the position is now == target. In reality the
       // motion control system might still be processing the action and the real tool position
@@ -1038,6 +1141,17 @@ uint8_t gc_execute_line(char *line)
       memcpy(gc_state.position, gc_block.values.xyz, sizeof(gc_block.values.xyz)); // gc_state.position[] = gc_block.values.xyz[]
     }
   }
+
+  // A motion rejected by soft limits is not planned and leaves the machine where the plan ends. Sync
+  // the parser position to the plan and report the recoverable error. No alarm or re-homing needed.
+  if (sys.soft_limit) {
+    sys.soft_limit = false;
+    if (sys.state != STATE_CHECK_MODE) { 
+      plan_get_planner_mpos(gc_state.position);
+      mc_uncompensate_position(gc_state.position);
+    }
+    FAIL(STATUS_TRAVEL_EXCEEDED);
+  }
   
   // [21. Program flow ]:
   // M0,M1,M2,M30: Perform non-running program flow actions. During a program pause, the buffer may 
@@ -1069,8 +1183,9 @@ uint8_t gc_execute_line(char *line)
 	  if (sys.state != STATE_CHECK_MODE) {
 		if (!(settings_read_coord_data(gc_state.modal.coord_select,coordinate_data))) { FAIL(STATUS_SETTING_READ_FAIL); } 
 		memcpy(gc_state.coord_system,coordinate_data,sizeof(coordinate_data));
-		spindle_stop();
-		coolant_stop();		
+		gc_update_work_offset();
+		spindle_run(SPINDLE_DISABLE, 0.0);
+		coolant_run(COOLANT_DISABLE);
 	  }
 	  
 	  report_feedback_message(MESSAGE_PROGRAM_END);
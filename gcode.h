@@ -57,6 +57,7 @@
 #define MOTION_MODE_PROBE_AWAY 6 // G38.4
 #define MOTION_MODE_PROBE_AWAY_NO_ERROR 7 // G38.5
 #define MOTION_MODE_NONE 8 // G80
+#define MOTION_MODE_SPINDLE_SYNC 9 // G33
 
 // Modal Group G2: Plane select
 #define PLANE_SELECT_XY 0 // G17 (Default: Must be zero)
@@ -168,6 +169,7 @@ typedef struct {
   float coord_offset[N_AXIS];   //    G92 ( )      . 
 								// .     .    
   float tool_length_offset;     //      .
+  int32_t work_offset[N_AXIS];  // Total work offset in reported units, 24.8 fixed-point. See gc_update_work_offset().
 } parser_state_t;
 extern parser_state_t gc_state;
 
@@ -191,4 +193,7 @@ uint8_t gc_execute_line(char *line);
 // Set g-code parser position. Input in steps.
 void gc_sync_position(); 
 
+// Update the fixed-point work offset used by the WPos status report.
+void gc_update_work_offset();
+
 #endif
@@ -25,12 +25,13 @@
 //     Grbl. .   .
 #include "config.h"
 #include "nuts_bolts.h"
+#include "eeprom.h"
 #include "settings.h"
 #include "system.h"
 #include "defaults.h"
 #include "cpu_map.h"
 #include "coolant_control.h"
-#include "eeprom.h"
+#include "spindle_control.h"
 #include "gcode.h"
 #include "limits.h"
 #include "motion_control.h"
@@ -40,7 +41,6 @@
 #include "protocol.h"
 #include "report.h"
 #include "serial.h"
-#include "spindle_control.h"
 #include "stepper.h"
 
 #endif
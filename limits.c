@@ -11,18 +11,25 @@
   #define HOMING_AXIS_LOCATE_SCALAR  5.0 // Must be > 1 to ensure limit switch is cleared.
 #endif
 
+// Limit port pins in use. The dual axis second switch shares the limit port with the axis switches.
+#ifdef ENABLE_DUAL_AXIS
+  #define LIMIT_PIN_MASK (LIMIT_MASK | (1<<DUAL_LIMIT_BIT))
+#else
+  #define LIMIT_PIN_MASK LIMIT_MASK
+#endif
+
 void limits_init() 
 {
-  LIMIT_DDR &= ~(LIMIT_MASK); //    
+  LIMIT_DDR &= ~(LIMIT_PIN_MASK); //    
 
   #ifdef DISABLE_LIMIT_PIN_PULL_UP
-    LIMIT_PORT &= ~(LIMIT_MASK); //  .   . Normal low operation. Requires external pull-down.
+    LIMIT_PORT &= ~(LIMIT_PIN_MASK); //  .   . Normal low operation. Requires external pull-down.
   #else
-    LIMIT_PORT |= (LIMIT_MASK);  //    .   . Enable internal pull-up resistors. Normal high operation.
+    LIMIT_PORT |= (LIMIT_PIN_MASK);  //    .   . Enable internal pull-up resistors. Normal high operation.
   #endif
 
   if (bit_istrue(settings.flags,BITFLAG_HARD_LIMIT_ENABLE)) {
-    LIMIT_PCMSK |= LIMIT_MASK; // Enable specific pins of the Pin Change Interrupt
+    LIMIT_PCMSK |= LIMIT_PIN_MASK; // Enable specific pins of the Pin Change Interrupt
     PCICR |= (1 << LIMIT_INT); // Enable Pin Change Interrupt
   } else {
     limits_disable(); 
@@ -39,7 +46,7 @@ void limits_init()
 // Disables hard limits.
 void limits_disable()
 {
-  LIMIT_PCMSK &= ~LIMIT_MASK;  // Disable specific pins of the Pin Change Interrupt
+  LIMIT_PCMSK &= ~LIMIT_PIN_MASK;  // Disable specific pins of the Pin Change Interrupt
   PCICR &= ~(1 << LIMIT_INT);  // Disable Pin Change Interrupt
 }
 
@@ -50,16 +57,19 @@ void limits_disable()
 uint8_t limits_get_state()
 {
   uint8_t limit_state = 0;
-  uint8_t pin = (LIMIT_PIN & LIMIT_MASK);
+  uint8_t pin = (LIMIT_PIN & LIMIT_PIN_MASK);
   #ifdef INVERT_LIMIT_PIN_MASK
     pin ^= INVERT_LIMIT_PIN_MASK;
   #endif
-  if (bit_isfalse(settings.flags,BITFLAG_INVERT_LIMIT_PINS)) { pin ^= LIMIT_MASK; }
+  if (!(SETTINGS_INVERT_LIMIT_PINS)) { pin ^= LIMIT_PIN_MASK; }
   if (pin) {  
     uint8_t idx;
     for (idx=0; idx<N_AXIS; idx++) {
       if (pin & get_limit_pin_mask(idx)) { limit_state |= (1 << idx); }
     }
+    #ifdef ENABLE_DUAL_AXIS
+      if (pin & (1<<DUAL_LIMIT_BIT)) { limit_state |= LIMIT_STATE_DUAL; }
+    #endif
   }
   return(limit_state);
 }
@@ -117,7 +127,254 @@ uint8_t limits_get_state()
   }
 #endif
 
- 
+
+#if defined(HOMING_CONCURRENT_AXES) || defined(ENABLE_DUAL_AXIS)
+// Reads the position of an axis, which the stepper ISR may be updating.
+static int32_t limits_get_axis_position(uint8_t idx)
+{
+  uint8_t sreg = SREG;
+  cli();
+  int32_t position = sys.position[idx];
+  SREG = sreg;
+  return(position);
+}
+
+
+#endif
+
+
+#ifdef HOMING_CONCURRENT_AXES
+
+// Homing phases of each axis. An axis seeks its switch, then backs off and slowly locates it again
+// N_HOMING_LOCATE_CYCLE times, and finally pulls off the switch.
+#define HOMING_PHASE_SEEK    0 // Approach the switch at the seek rate.
+#define HOMING_PHASE_BACKOFF 1 // Back off the switch by the pull-off distance before locating it.
+#define HOMING_PHASE_LOCATE  2 // Approach the switch at the feed rate.
+#define HOMING_PHASE_PULLOFF 3 // Final pull-off away from the switch.
+#define HOMING_PHASE_DONE    4
+
+// Running data of the homing state machine of one axis.
+typedef struct {
+  uint8_t phase;
+  uint8_t n_locate;          // Locate phases remaining.
+  uint8_t settle;            // Flags the axis is waiting out the debounce delay after a switch trigger.
+  uint32_t settle_deadline;  // Millisecond tick at which the debounce delay is complete.
+  int32_t start_position;    // Axis position at the start of the current phase (steps)
+  int32_t trigger_position;  // Axis position at the last switch trigger (steps)
+  float travel;              // Maximum travel of the current phase (steps)
+  float max_rate;            // Step rate of the current phase (steps/sec)
+  float rate;                // Current step rate (steps/sec)
+  float acceleration;        // Axis acceleration (steps/sec^2)
+} homing_axis_t;
+
+
+// Returns if the given homing phase moves the axis towards its switch.
+static uint8_t limits_homing_toward(uint8_t phase)
+{
+  return((phase == HOMING_PHASE_SEEK) || (phase == HOMING_PHASE_LOCATE));
+}
+
+
+// Returns if the axis moves in the negative direction in the given homing phase. Axes with the
+// homing direction mask bit set approach their switch in the negative direction.
+static uint8_t limits_homing_reverse(uint8_t idx, uint8_t phase)
+{
+  if (bit_istrue(SETTINGS_HOMING_DIR_MASK,bit(idx))) { return(limits_homing_toward(phase)); }
+  return(!limits_homing_toward(phase));
+}
+
+
+// Starts a homing phase of an axis from rest. Rates are limited by the axis maximum rate.
+static void limits_homing_begin_phase(homing_axis_t *axis, uint8_t idx, uint8_t phase)
+{
+  axis->phase = phase;
+  axis->start_position = limits_get_axis_position(idx);
+  #ifdef ENABLE_DUAL_AXIS
+    // Both motors of the dual axis move again at the start of every phase.
+    if (idx == DUAL_AXIS_SELECT) {
+      sys.homing_axis_lock |= get_step_pin_mask(idx);
+      sys.homing_axis_lock_dual = true;
+    }
+  #endif
+  axis->rate = 0.0;
+  float rate = settings.homing_seek_rate;
+  switch (phase) {
+    case HOMING_PHASE_SEEK:
+      // NOTE: settings.max_travel[] is stored as a negative value.
+      axis->travel = (-HOMING_AXIS_SEARCH_SCALAR)*settings.max_travel[idx];
+      break;
+    case HOMING_PHASE_LOCATE:
+      axis->travel = settings.homing_pulloff*HOMING_AXIS_LOCATE_SCALAR;
+      rate = settings.homing_feed_rate;
+      break;
+    default: // HOMING_PHASE_BACKOFF and HOMING_PHASE_PULLOFF
+      axis->travel = settings.homing_pulloff;
+  }
+  rate = min(rate,settings.max_rate[idx]);
+  axis->travel *= settings.steps_per_mm[idx];
+  axis->max_rate = rate*settings.steps_per_mm[idx]/60.0;
+}
+
+
+// Sets the machine position of an axis that has completed homing. The position is taken relative
+// to the last switch trigger, so the pull-off distance actually traveled does not matter.
+static void limits_homing_set_position(homing_axis_t *axis, uint8_t idx)
+{
+  int32_t trigger_position;
+  #ifdef HOMING_FORCE_SET_ORIGIN
+    // The origin is at the pulled-off location. The switch lies one pull-off distance behind it.
+    trigger_position = lround(settings.homing_pulloff*settings.steps_per_mm[idx]);
+    if (bit_istrue(SETTINGS_HOMING_DIR_MASK,bit(idx))) { trigger_position = -trigger_position; }
+  #else
+    // NOTE: settings.max_travel[] is stored as a negative value.
+    if (bit_istrue(SETTINGS_HOMING_DIR_MASK,bit(idx))) {
+      trigger_position = lround(settings.max_travel[idx]*settings.steps_per_mm[idx]);
+    } else {
+      trigger_position = 0;
+    }
+  #endif
+  sys.position[idx] = trigger_position + (sys.position[idx] - axis->trigger_position);
+}
+
+
+// Homes the specified cycle axes and sets their machine positions. Every axis runs its own seek,
+// locate, and pull-off state machine, driven by the homing step generator in the stepper ISR.
+// Axes stop dead on a switch trigger, as the rapid stops locate the trigger point, and ramp up
+// and down with their own acceleration otherwise. Switch debounce delays are timed per axis
+// against the millisecond tick, so no axis blocks the others.
+// NOTE: Only the abort realtime command can interrupt this process.
+void limits_go_home(uint8_t cycle_mask)
+{
+  if (sys.abort) { return; } // Block if system reset has been issued.
+
+  homing_axis_t homing_axis[N_AXIS];
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    homing_axis[idx].phase = HOMING_PHASE_DONE;
+    if (bit_istrue(cycle_mask,bit(idx))) {
+      homing_axis[idx].n_locate = N_HOMING_LOCATE_CYCLE;
+      homing_axis[idx].settle = false;
+      homing_axis[idx].acceleration = settings.acceleration[idx]*settings.steps_per_mm[idx]/3600.0;
+      limits_homing_begin_phase(&homing_axis[idx], idx, HOMING_PHASE_SEEK);
+    }
+  }
+  #ifdef ENABLE_DUAL_AXIS
+    // Travel of the dual axis between its first and second switch trigger, while it squares itself.
+    sys.homing_axis_lock = STEP_MASK;
+    sys.homing_axis_lock_dual = true;
+    uint8_t dual_squaring = false;
+    int32_t dual_squaring_position = 0;
+    float dual_fail_steps = DUAL_AXIS_HOMING_FAIL_DISTANCE*settings.steps_per_mm[DUAL_AXIS_SELECT];
+  #endif
+  st_homing_start();
+
+  uint32_t tick_ms = system_get_tick_ms();
+  uint8_t active_mask;
+  do {
+    // Update step rates once per millisecond tick. Limit switches are checked every pass.
+    uint32_t current_tick_ms = system_get_tick_ms();
+    float dt = (current_tick_ms - tick_ms)*0.001; // (sec)
+    tick_ms = current_tick_ms;
+    uint8_t limit_state = limits_get_state();
+
+    active_mask = 0;
+    for (idx=0; idx<N_AXIS; idx++) {
+      homing_axis_t *axis = &homing_axis[idx];
+      if (axis->phase == HOMING_PHASE_DONE) { continue; }
+      active_mask |= bit(idx);
+
+      if (axis->settle) {
+        if ((int32_t)(current_tick_ms - axis->settle_deadline) < 0) { continue; }
+        axis->settle = false;
+        limits_homing_begin_phase(axis, idx, axis->phase);
+      }
+
+      uint8_t reverse = limits_homing_reverse(idx, axis->phase);
+      int32_t position = limits_get_axis_position(idx);
+      uint8_t triggered = (limit_state & bit(idx));
+      #ifdef ENABLE_DUAL_AXIS
+        if ((idx == DUAL_AXIS_SELECT) && limits_homing_toward(axis->phase)) {
+          // Lock out each motor of the dual axis on its own switch. The axis is triggered, and 
+          // square, once both motors are locked out.
+          if (triggered) { sys.homing_axis_lock &= ~get_step_pin_mask(idx); }
+          if (limit_state & LIMIT_STATE_DUAL) { sys.homing_axis_lock_dual = false; }
+          uint8_t locked = !(sys.homing_axis_lock & get_step_pin_mask(idx));
+          triggered = (locked && !sys.homing_axis_lock_dual);
+          if (triggered) {
+            dual_squaring = false;
+          } else if (locked || !sys.homing_axis_lock_dual) {
+            if (!dual_squaring) {
+              dual_squaring = true;
+              dual_squaring_position = position;
+            } else if (labs(position - dual_squaring_position) > dual_fail_steps) {
+              // Homing failure: Second switch not found within the maximum squaring travel.
+              mc_reset(); // Stop motors, if they are running.
+              protocol_execute_realtime();
+              return;
+            }
+          }
+        }
+      #endif
+      if (limits_homing_toward(axis->phase) && triggered) {
+        // Switch triggered. Stop dead, record the trigger point, and let the axis settle before
+        // backing off.
+        st_homing_set_rate(idx, 0.0, reverse);
+        axis->trigger_position = position;
+        if (axis->phase == HOMING_PHASE_LOCATE) { axis->n_locate--; }
+        if (axis->n_locate) { axis->phase = HOMING_PHASE_BACKOFF; }
+        else { axis->phase = HOMING_PHASE_PULLOFF; }
+        axis->settle = true;
+        axis->settle_deadline = current_tick_ms + settings.homing_debounce_delay;
+        continue;
+      }
+
+      float remaining = axis->travel - labs(position - axis->start_position);
+      if (remaining <= 0.0) {
+        st_homing_set_rate(idx, 0.0, reverse);
+        // Homing failure: Switch not found during approach, or still engaged after pulling off.
+        #ifdef ENABLE_DUAL_AXIS
+          if ((idx == DUAL_AXIS_SELECT) && (limit_state & LIMIT_STATE_DUAL)) { limit_state |= bit(idx); }
+        #endif
+        if (limits_homing_toward(axis->phase) || (limit_state & bit(idx))) {
+          mc_reset(); // Stop motors, if they are running.
+          protocol_execute_realtime();
+          return;
+        }
+        if (axis->phase == HOMING_PHASE_BACKOFF) {
+          limits_homing_begin_phase(axis, idx, HOMING_PHASE_LOCATE);
+        } else {
+          limits_homing_set_position(axis, idx);
+          axis->phase = HOMING_PHASE_DONE;
+        }
+        continue;
+      }
+
+      if (dt > 0.0) {
+        // Accelerate to the phase rate. Moves off the switch also decelerate to stop at their end.
+        axis->rate += axis->acceleration*dt;
+        if (axis->rate > axis->max_rate) { axis->rate = axis->max_rate; }
+        if (!limits_homing_toward(axis->phase)) {
+          float stop_rate = sqrt(2.0*axis->acceleration*remaining);
+          if (axis->rate > stop_rate) { axis->rate = stop_rate; }
+        }
+        st_homing_set_rate(idx, axis->rate, reverse);
+      }
+    }
+
+    // Exit routines: No time to run protocol_execute_realtime() in this loop.
+    if (sys_rt_exec_state & (EXEC_SAFETY_DOOR | EXEC_RESET)) {
+      mc_reset(); // Stop motors, if they are running.
+      protocol_execute_realtime();
+      return;
+    }
+  } while (active_mask);
+
+  st_reset(); // Stop the homing step generator.
+  plan_sync_position(); // Sync planner position to homed machine position.
+}
+
+#else
+
 // Homes the specified cycle axes, sets the machine position, and performs a pull-off motion after
 // completing. Homing is a special motion case, which involves rapid uncontrolled stops to locate
 // the trigger point of the limit switches. The rapid stops are handled by a system level axis lock 
@@ -154,6 +411,11 @@ void limits_go_home(uint8_t cycle_mask)
   float homing_rate = settings.homing_seek_rate;
 
   uint8_t limit_state, axislock, n_active_axis;
+  uint8_t pulloff_mask = cycle_mask; // Limit switches that must clear on pull-off.
+  #ifdef ENABLE_DUAL_AXIS
+    if (bit_istrue(cycle_mask,bit(DUAL_AXIS_SELECT))) { pulloff_mask |= LIMIT_STATE_DUAL; }
+    float dual_fail_steps = DUAL_AXIS_HOMING_FAIL_DISTANCE*settings.steps_per_mm[DUAL_AXIS_SELECT];
+  #endif
   do {
 
     system_convert_array_steps_to_mpos(target,sys.position);
@@ -181,7 +443,7 @@ void limits_go_home(uint8_t cycle_mask)
         #endif
         // Set target direction based on cycle mask and homing cycle approach state.
         // NOTE: This happens to compile smaller than any other implementation tried.
-        if (bit_istrue(settings.homing_dir_mask,bit(idx))) {
+        if (bit_istrue(SETTINGS_HOMING_DIR_MASK,bit(idx))) {
           if (approach) { target[idx] = -max_travel; }
           else { target[idx] = max_travel; }
         } else { 
@@ -195,6 +457,11 @@ void limits_go_home(uint8_t cycle_mask)
     }
     homing_rate *= sqrt(n_active_axis); // [sqrt(N_AXIS)] Adjust so individual axes all move at homing rate.
     sys.homing_axis_lock = axislock;
+    #ifdef ENABLE_DUAL_AXIS
+      sys.homing_axis_lock_dual = bit_istrue(cycle_mask,bit(DUAL_AXIS_SELECT));
+      uint8_t dual_squaring = false;
+      int32_t dual_squaring_position = 0;
+    #endif
 
     plan_sync_position(); // Sync planner position to current machine position.
     
@@ -224,6 +491,23 @@ void limits_go_home(uint8_t cycle_mask)
           }
         }
         sys.homing_axis_lock = axislock;
+        #ifdef ENABLE_DUAL_AXIS
+          // Lock out the second motor on its own switch, squaring the axis. Fail if the second 
+          // switch is not found within the maximum squaring travel after the first.
+          if (limit_state & LIMIT_STATE_DUAL) { sys.homing_axis_lock_dual = false; }
+          if (bit_istrue(cycle_mask,bit(DUAL_AXIS_SELECT)) && 
+              (!(axislock & step_pin[DUAL_AXIS_SELECT]) != !sys.homing_axis_lock_dual)) {
+            int32_t position = limits_get_axis_position(DUAL_AXIS_SELECT);
+            if (!dual_squaring) {
+              dual_squaring = true;
+              dual_squaring_position = position;
+            } else if (labs(position - dual_squaring_position) > dual_fail_steps) {
+              mc_reset(); // Stop motors, if they are running.
+              protocol_execute_realtime();
+              return;
+            }
+          }
+        #endif
       }
 
       st_prep_buffer(); // Check and prep segment buffer. NOTE: Should take no longer than 200us.
@@ -232,7 +516,7 @@ void limits_go_home(uint8_t cycle_mask)
       if (sys_rt_exec_state & (EXEC_SAFETY_DOOR | EXEC_RESET | EXEC_CYCLE_STOP)) {
         // Homing failure: Limit switches are still engaged after pull-off motion
         if ( (sys_rt_exec_state & (EXEC_SAFETY_DOOR | EXEC_RESET)) ||  // Safety door or reset issued
-           (!approach && (limits_get_state() & cycle_mask)) ||  // Limit switch still engaged after pull-off motion
+           (!approach && (limits_get_state() & pulloff_mask)) ||  // Limit switch still engaged after pull-off motion
            ( approach && (sys_rt_exec_state & EXEC_CYCLE_STOP)) ) { // Limit switch not found during approach.
           mc_reset(); // Stop motors, if they are running.
           protocol_execute_realtime();
@@ -244,7 +528,11 @@ void limits_go_home(uint8_t cycle_mask)
         } 
       }
 
-    } while (STEP_MASK & axislock);
+    #ifdef ENABLE_DUAL_AXIS
+      } while ((STEP_MASK & axislock) || (approach && sys.homing_axis_lock_dual));
+    #else
+      } while (STEP_MASK & axislock);
+    #endif
 
     st_reset(); // Immediately force kill steppers and reset step segment buffer.
     plan_reset(); // Reset planner buffer to zero planner current position and to clear previous motions.
@@ -279,7 +567,7 @@ void limits_go_home(uint8_t cycle_mask)
       #ifdef HOMING_FORCE_SET_ORIGIN
         set_axis_position = 0;
       #else 
-        if ( bit_istrue(settings.homing_dir_mask,bit(idx)) ) {
+        if ( bit_istrue(SETTINGS_HOMING_DIR_MASK,bit(idx)) ) {
           set_axis_position = lround((settings.max_travel[idx]+settings.homing_pulloff)*settings.steps_per_mm[idx]);
         } else {
           set_axis_position = lround(-settings.homing_pulloff*settings.steps_per_mm[idx]);
@@ -309,43 +597,90 @@ void limits_go_home(uint8_t cycle_mask)
   // sys.state = STATE_HOMING; // Ensure system state set as homing before returning. 
 }
 
+#endif
+
+
+// Soft limit travel of each axis in absolute steps. Precomputed from the settings whenever they
+// change, so the planner checks each block target with integer compares only.
+static int32_t soft_limit_min[N_AXIS];
+static int32_t soft_limit_max[N_AXIS];
 
-// Performs a soft limit check. Called from mc_line() only. Assumes the machine has been homed,
-// the workspace volume is in all negative space, and the system is in normal operation.
-void limits_soft_check(float *target)
+
+// Computes the step space soft limit travel from the axis travel and steps/mm settings. Called
+// after the settings are initialized, restored, or stored.
+void limits_update_soft_limits()
 {
   uint8_t idx;
   for (idx=0; idx<N_AXIS; idx++) {
-   
+    // NOTE: max_travel is stored as negative
+    int32_t travel = lround(settings.max_travel[idx]*settings.steps_per_mm[idx]);
     #ifdef HOMING_FORCE_SET_ORIGIN
       // When homing forced set origin is enabled, soft limits checks need to account for directionality.
-      // NOTE: max_travel is stored as negative
-      if (bit_istrue(settings.homing_dir_mask,bit(idx))) {
-        if (target[idx] < 0 || target[idx] > -settings.max_travel[idx]) { sys.soft_limit = true; }
-      } else {
-        if (target[idx] > 0 || target[idx] < settings.max_travel[idx]) { sys.soft_limit = true; }
+      if (bit_istrue(SETTINGS_HOMING_DIR_MASK,bit(idx))) {
+        soft_limit_min[idx] = 0;
+        soft_limit_max[idx] = -travel;
+        continue;
       }
-    #else  
-      // NOTE: max_travel is stored as negative
-      if (target[idx] > 0 || target[idx] < settings.max_travel[idx]) { sys.soft_limit = true; }
     #endif
-    
-    if (sys.soft_limit) {
-      // Force feed hold if cycle is active. All buffered blocks are guaranteed to be within 
-      // workspace volume so just come to a controlled stop so position is not lost. When complete
-      // enter alarm mode.
-      if (sys.state == STATE_CYCLE) {
-        bit_true_atomic(sys_rt_exec_state, EXEC_FEED_HOLD);
-        do {
-          protocol_execute_realtime();
-          if (sys.abort) { return; }
-        } while ( sys.state != STATE_IDLE );
-      }
-    
-      mc_reset(); // Issue system reset and ensure spindle and coolant are shutdown.
-      bit_true_atomic(sys_rt_exec_alarm, (EXEC_ALARM_SOFT_LIMIT|EXEC_CRITICAL_EVENT)); // Indicate soft limit critical event
-      protocol_execute_realtime(); // Execute to enter critical event loop and system abort
-      return;
-    }
+    soft_limit_min[idx] = travel;
+    soft_limit_max[idx] = 0;
+  }
+}
+
+
+// Converts a target in millimeters to absolute steps, as the planner does.
+static void limits_convert_target_to_steps(int32_t *target_steps, float *target)
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    target_steps[idx] = lround(target[idx]*settings.steps_per_mm[idx]);
   }
 }
+
+
+// Checks a target in absolute steps against the soft limit travel. Returns true if outside.
+uint8_t limits_check_travel_steps(int32_t *target_steps)
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    if (target_steps[idx] < soft_limit_min[idx] || target_steps[idx] > soft_limit_max[idx]) { return(true); }
+  }
+  return(false);
+}
+
+
+// Checks the target against the machine travel volume. Assumes the machine has been homed, the
+// workspace volume is in all negative space, and the system is in normal operation. Shared by 
+// soft limits outside the planner and jogging, which rejects an out-of-bounds jog target instead
+// of alarming.
+uint8_t limits_check_travel(float *target)
+{
+  int32_t target_steps[N_AXIS];
+  limits_convert_target_to_steps(target_steps, target);
+  return(limits_check_travel_steps(target_steps));
+}
+
+
+// Performs a soft limit check of a target in absolute steps. Called from plan_buffer_line() for 
+// every planned motion. A target out of bounds is rejected rather than alarmed. All buffered blocks
+// are guaranteed to be within the workspace volume, so the machine comes to a normal stop at the 
+// end of the plan and position is never lost. Flags the violation for the g-code parser to report
+// as a recoverable error, and returns true, if the target must be rejected.
+uint8_t limits_soft_check_steps(int32_t *target_steps)
+{
+  if (limits_check_travel_steps(target_steps)) {
+    sys.soft_limit = true;
+    return(true);
+  }
+  return(false);
+}
+
+
+// Performs a soft limit check of a target in millimeters. Called for arc bounding boxes and check 
+// mode motions, which are not checked by the planner.
+uint8_t limits_soft_check(float *target)
+{
+  int32_t target_steps[N_AXIS];
+  limits_convert_target_to_steps(target_steps, target);
+  return(limits_soft_check_steps(target_steps));
+}
@@ -13,10 +13,24 @@ void limits_disable();
 // Returns limit state as a bit-wise uint8 variable.
 uint8_t limits_get_state();
 
+// Limit state bit of the dual axis second switch, past the axis bits.
+#ifdef ENABLE_DUAL_AXIS
+  #define LIMIT_STATE_DUAL bit(N_AXIS)
+#endif
+
 // Perform one portion of the homing cycle based on the input settings.
 void limits_go_home(uint8_t cycle_mask);
 
-// Check for soft limit violations
-void limits_soft_check(float *target);
+// Precompute the step space soft limit travel from the settings
+void limits_update_soft_limits();
+
+// Check for soft limit violations of a target in millimeters or in absolute steps. Returns true, 
+// and flags the violation, if the target must be rejected.
+uint8_t limits_soft_check(float *target);
+uint8_t limits_soft_check_steps(int32_t *target_steps);
+
+// Returns true if the target is outside of the machine travel. Does not alter system state.
+uint8_t limits_check_travel(float *target);
+uint8_t limits_check_travel_steps(int32_t *target_steps);
 
 #endif
\ No newline at end of file
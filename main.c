@@ -67,6 +67,7 @@ int main(void)
     sys_rt_exec_alarm = 0;
     sys.suspend = false;
     sys.soft_limit = false;
+    sys.delay = DELAY_NONE;
               
     // Запустите основной цикл Grbl. Входы процессов обрабатывают и выполняют их.
     protocol_main_loop();
@@ -3,6 +3,16 @@
 
 #include "grbl.h"
 
+#ifdef ENABLE_BACKLASH_COMPENSATION
+  // Backlash tracking. The direction mask bit is set when an axis last moved in the negative
+  // direction. Directions are only trusted for axes in the known mask, which are set once the
+  // axis has moved or been homed.
+  static uint8_t backlash_dir_mask;
+  static uint8_t backlash_known_mask;
+
+  void mc_backlash_reset() { backlash_known_mask = 0; }
+#endif
+
 /*
 // Execute linear motion in absolute millimeter coordinates. Feed rate given in millimeters/second
 // unless invert_feed_rate is true. Then the feed_rate means that the motion should be completed in
@@ -19,17 +29,16 @@
 //      ,      .  
 // mc_line  plan_buffer_line          
 //       -    .
+// Queues a line motion in the planner, after a backlash take-up motion, if any. Waits for room in
+// the planner buffer.
 #ifdef USE_LINE_NUMBERS
-  void mc_line(float *target, float feed_rate, uint8_t invert_feed_rate, int32_t line_number)
+  static void mc_queue_line(float *target, float feed_rate, uint8_t invert_feed_rate, int32_t line_number)
 #else
-  void mc_line(float *target, float feed_rate, uint8_t invert_feed_rate)
+  static void mc_queue_line(float *target, float feed_rate, uint8_t invert_feed_rate)
 #endif
 {
-  //  ,     .         Grbl.
-  if (bit_istrue(settings.flags,BITFLAG_SOFT_LIMIT_ENABLE)) { limits_soft_check(target); }    
-      
-  //     gcode  ,  .     .
-  if (sys.state == STATE_CHECK_MODE) { return; }
+  // A jog cancel while waiting on a full planner flushes the motions this line would follow. 
+  uint8_t jog_cancel_count = sys.jog_cancel_count;
     
   // NOTE: Backlash compensation may be installed here. It will need direction info to track when
   // to insert a backlash line motion(s) before the intended line motion and will require its own
@@ -45,14 +54,61 @@
   // doesn't update the machine position values. Since the position values used by the g-code
   // parser and planner are separate from the system machine positions, this is doable.
 
+  // NOTE: Backlash compensation is installed here as the middle-ground described above. When a
+  // line reverses any axis, a take-up motion of the reversing axes is planned first. The planner
+  // flags it so the stepper does not count its steps, which keeps sys.position and the reported
+  // positions in machine coordinates. The g-code parser position is never involved.
+  #ifdef ENABLE_BACKLASH_COMPENSATION
+    float backlash_target[N_AXIS];
+    plan_get_planner_mpos(backlash_target);
+    uint8_t idx, backlash_axes = 0;
+    for (idx=0; idx<N_AXIS; idx++) {
+      // Compare in whole steps, so round-off between arc segments is not taken for a reversal.
+      int32_t delta_steps = lround(target[idx]*settings.steps_per_mm[idx]) - 
+                            lround(backlash_target[idx]*settings.steps_per_mm[idx]);
+      if (delta_steps == 0) { continue; }
+      uint8_t is_negative = (delta_steps < 0);
+      if (bit_istrue(backlash_known_mask,bit(idx)) && (settings.backlash[idx] > 0.0) &&
+          (is_negative != bit_istrue(backlash_dir_mask,bit(idx)))) {
+        if (is_negative) { backlash_target[idx] -= settings.backlash[idx]; }
+        else { backlash_target[idx] += settings.backlash[idx]; }
+        backlash_axes |= bit(idx);
+      }
+      if (is_negative) { backlash_dir_mask |= bit(idx); }
+      else { backlash_dir_mask &= ~bit(idx); }
+      backlash_known_mask |= bit(idx);
+    }
+    if (backlash_axes) {
+      do {
+        protocol_execute_realtime(); // Check for any run-time commands
+        if (sys.abort) { return; } // Bail, if system abort.
+        if ( plan_check_full_buffer() ) { protocol_auto_cycle_start(); } // Auto-cycle start when buffer is full.
+        else { break; }
+      } while (1);
+      if (sys.jog_cancel_count != jog_cancel_count) { return; } // Jog cancelled. Drop the line.
+      #ifdef USE_LINE_NUMBERS
+        plan_buffer_backlash_line(backlash_target, line_number);
+      #else
+        plan_buffer_backlash_line(backlash_target);
+      #endif
+    }
+  #endif
+
   // If the buffer is full: good! That means we are well ahead of the robot. 
   // Remain in this loop until there is room in the buffer.
+  #ifdef ENABLE_PERFORMANCE_COUNTERS
+    uint32_t full_start_ms = system_get_tick_ms();
+  #endif
   do {
     protocol_execute_realtime(); //     
     if (sys.abort) { return; } // Bail, if system abort.
     if ( plan_check_full_buffer() ) { protocol_auto_cycle_start(); } // Auto-cycle start when buffer is full.
     else { break; }
   } while (1);
+  #ifdef ENABLE_PERFORMANCE_COUNTERS
+    perf.planner_full_ms += system_get_tick_ms() - full_start_ms;
+  #endif
+  if (sys.jog_cancel_count != jog_cancel_count) { return; } // Jog cancelled. Drop the line.
 
   //        
   #ifdef USE_LINE_NUMBERS
@@ -63,6 +119,232 @@
 }
 
 
+#ifdef ENABLE_HEIGHT_MAP
+height_map_t height_map;
+
+
+// Returns the height map Z offset at an XY position by bilinear interpolation of the enclosing map
+// cell. Positions outside of the map take the height at the nearest map edge.
+static float mc_height_map_offset(float *position)
+{
+  uint8_t index[2];
+  float fraction[2];
+  uint8_t axis;
+  for (axis=X_AXIS; axis<=Y_AXIS; axis++) {
+    uint8_t n_point = (axis == X_AXIS) ? HEIGHT_MAP_POINTS_X : HEIGHT_MAP_POINTS_Y;
+    float cell = (position[axis]-height_map.origin[axis])*height_map.inv_spacing[axis];
+    if (cell < 0.0) { cell = 0.0; }
+    if (cell > n_point-1) { cell = n_point-1; }
+    index[axis] = cell;
+    if (index[axis] > n_point-2) { index[axis] = n_point-2; } // Last point interpolates in the last cell.
+    fraction[axis] = cell-index[axis];
+  }
+  float *row = height_map.z[index[Y_AXIS]];
+  float z_0 = row[index[X_AXIS]] + (row[index[X_AXIS]+1]-row[index[X_AXIS]])*fraction[X_AXIS];
+  row = height_map.z[index[Y_AXIS]+1];
+  float z_1 = row[index[X_AXIS]] + (row[index[X_AXIS]+1]-row[index[X_AXIS]])*fraction[X_AXIS];
+  return(z_0 + (z_1-z_0)*fraction[Y_AXIS]);
+}
+
+
+// Queues a line motion that follows the height map. The line is split where it crosses the inner
+// grid lines of the map, since the surface is only linear within a cell, and each piece end point
+// Z is offset by the map height. The line starts from the end of the plan, less its map offset.
+#ifdef USE_LINE_NUMBERS
+  static void mc_height_map_line(float *target, float feed_rate, uint8_t invert_feed_rate, int32_t line_number)
+#else
+  static void mc_height_map_line(float *target, float feed_rate, uint8_t invert_feed_rate)
+#endif
+{
+  float position[N_AXIS], delta[N_AXIS], piece[N_AXIS];
+  uint8_t jog_cancel_count = sys.jog_cancel_count;
+  plan_get_planner_mpos(position);
+  mc_uncompensate_position(position);
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) { delta[idx] = target[idx]-position[idx]; }
+
+  // Next inner grid line crossed along X and Y, searched in the direction of travel. Grid line
+  // indices outside of 1..(n-2) indicate no more crossings.
+  int16_t grid_line[2];
+  grid_line[X_AXIS] = (delta[X_AXIS] < 0.0) ? HEIGHT_MAP_POINTS_X-2 : 1;
+  grid_line[Y_AXIS] = (delta[Y_AXIS] < 0.0) ? HEIGHT_MAP_POINTS_Y-2 : 1;
+  
+  float t_start = 0.0, t_end;
+  do {
+    t_end = 1.0;
+    uint8_t axis;
+    for (axis=X_AXIS; axis<=Y_AXIS; axis++) {
+      if (delta[axis] == 0.0) { continue; }
+      int16_t n_point = (axis == X_AXIS) ? HEIGHT_MAP_POINTS_X : HEIGHT_MAP_POINTS_Y;
+      while ((grid_line[axis] >= 1) && (grid_line[axis] <= n_point-2)) {
+        float t_line = (height_map.origin[axis] + grid_line[axis]*height_map.spacing[axis] - position[axis])/delta[axis];
+        if (t_line > t_start) {
+          if (t_line < t_end) { t_end = t_line; }
+          break;
+        }
+        if (delta[axis] < 0.0) { grid_line[axis]--; }
+        else { grid_line[axis]++; }
+      }
+    }
+
+    if (t_end < 1.0) {
+      for (idx=0; idx<N_AXIS; idx++) { piece[idx] = position[idx] + t_end*delta[idx]; }
+    } else {
+      memcpy(piece, target, sizeof(piece));
+    }
+    piece[Z_AXIS] += mc_height_map_offset(piece);
+    
+    // Inverse time feed rates apply to the whole line. Scale by the piece fraction of the line.
+    float piece_feed_rate = feed_rate;
+    if (invert_feed_rate) { piece_feed_rate /= (t_end-t_start); }
+    #ifdef USE_LINE_NUMBERS
+      mc_queue_line(piece, piece_feed_rate, invert_feed_rate, line_number);
+    #else
+      mc_queue_line(piece, piece_feed_rate, invert_feed_rate);
+    #endif
+    if (sys.abort || sys.soft_limit) { return; } // Bail on system abort or a rejected piece.
+    if (sys.jog_cancel_count != jog_cancel_count) { return; } // Bail on a dropped jog piece.
+    t_start = t_end;
+  } while (t_end < 1.0);
+}
+
+
+// Clears the height map and disables Z compensation.
+void mc_height_map_clear()
+{
+  memset(&height_map, 0, sizeof(height_map_t));
+}
+
+
+// Probes the height map over an XY area of size[] from the current position, which is the first
+// map point. Each point is approached at rapid rate from the starting height and probed down up to
+// depth at feed_rate, like G38.2, before retracting. Points are probed row by row, in alternating
+// directions, to minimize travel. The map is enabled once all points are probed.
+// Ends a height map probe run with a motion rejected by soft limits. Nothing past the plan end was 
+// queued, so the parser is resynced to it, and the map is left disabled.
+static uint8_t mc_height_map_probe_rejected()
+{
+  sys.soft_limit = false;
+  plan_get_planner_mpos(gc_state.position);
+  mc_uncompensate_position(gc_state.position);
+  return(STATUS_TRAVEL_EXCEEDED);
+}
+
+
+uint8_t mc_height_map_probe(float *size, float depth, float feed_rate)
+{
+  if ((depth <= 0.0) || (feed_rate <= 0.0)) { return(STATUS_NEGATIVE_VALUE); }
+  if ((size[X_AXIS] == 0.0) || (size[Y_AXIS] == 0.0)) { return(STATUS_INVALID_STATEMENT); }
+  mc_height_map_clear(); // Probing motions must not follow an old map.
+
+  float position[N_AXIS];
+  system_convert_array_steps_to_mpos(position, sys.position);
+  float clearance_z = position[Z_AXIS];
+  uint8_t axis;
+  for (axis=X_AXIS; axis<=Y_AXIS; axis++) {
+    uint8_t n_point = (axis == X_AXIS) ? HEIGHT_MAP_POINTS_X : HEIGHT_MAP_POINTS_Y;
+    height_map.origin[axis] = position[axis];
+    height_map.spacing[axis] = size[axis]/(n_point-1);
+    if (height_map.spacing[axis] < 0.0) {
+      // Keep the origin at the minimum corner, so map indices increase with position.
+      height_map.origin[axis] += size[axis];
+      height_map.spacing[axis] = -height_map.spacing[axis];
+    }
+    height_map.inv_spacing[axis] = 1.0/height_map.spacing[axis];
+  }
+
+  uint8_t i, j, n;
+  for (j=0; j<HEIGHT_MAP_POINTS_Y; j++) {
+    for (n=0; n<HEIGHT_MAP_POINTS_X; n++) {
+      if (j & 1) { i = HEIGHT_MAP_POINTS_X-1-n; }
+      else { i = n; }
+      position[X_AXIS] = height_map.origin[X_AXIS] + i*height_map.spacing[X_AXIS];
+      position[Y_AXIS] = height_map.origin[Y_AXIS] + j*height_map.spacing[Y_AXIS];
+      position[Z_AXIS] = clearance_z;
+      #ifdef USE_LINE_NUMBERS
+        mc_line(position, -1.0, false, 0);
+      #else
+        mc_line(position, -1.0, false);
+      #endif
+      if (sys.soft_limit) { return(mc_height_map_probe_rejected()); }
+      position[Z_AXIS] = clearance_z-depth;
+      #ifdef USE_LINE_NUMBERS
+        mc_probe_cycle(position, feed_rate, false, 0.0, false, false, 0);
+      #else
+        mc_probe_cycle(position, feed_rate, false, 0.0, false, false);
+      #endif
+      if (sys.soft_limit) { return(mc_height_map_probe_rejected()); }
+      // Bail on system abort or a probe failure alarm. The map is left disabled.
+      if (sys.abort || (sys.state == STATE_ALARM)) { return(STATUS_OK); }
+      height_map.z[j][i] = system_convert_axis_steps_to_mpos(sys.probe_position, Z_AXIS);
+      position[Z_AXIS] = clearance_z;
+      #ifdef USE_LINE_NUMBERS
+        mc_line(position, -1.0, false, 0);
+      #else
+        mc_line(position, -1.0, false);
+      #endif
+      if (sys.soft_limit) { return(mc_height_map_probe_rejected()); }
+    }
+  }
+  protocol_buffer_synchronize(); // Complete the last retract.
+  if (sys.abort) { return(STATUS_OK); }
+  gc_sync_position(); // Probing motions bypass the g-code parser.
+
+  // Heights are relative to the first map point, where the work Z zero is normally set.
+  float z_reference = height_map.z[0][0];
+  for (j=0; j<HEIGHT_MAP_POINTS_Y; j++) {
+    for (i=0; i<HEIGHT_MAP_POINTS_X; i++) { height_map.z[j][i] -= z_reference; }
+  }
+  height_map.enabled = true;
+  return(STATUS_OK);
+}
+#endif
+
+
+// Removes the height map Z compensation. Every parser position read back from the plan or the 
+// machine must pass through here, or later blocks without a Z word would be compensated twice.
+void mc_uncompensate_position(float *position)
+{
+  #ifdef ENABLE_HEIGHT_MAP
+    if (height_map.enabled) { position[Z_AXIS] -= mc_height_map_offset(position); }
+  #endif
+}
+
+
+// Execute linear motion in absolute millimeter coordinates. Check mode and the height map are 
+// handled here, before the motion is queued.
+#ifdef USE_LINE_NUMBERS
+  void mc_line(float *target, float feed_rate, uint8_t invert_feed_rate, int32_t line_number)
+#else
+  void mc_line(float *target, float feed_rate, uint8_t invert_feed_rate)
+#endif
+{
+  // Soft limits are checked in step space by the planner. Check mode does not plan motions, so 
+  // check them here. If in check gcode mode, prevent motion by blocking planner.
+  if (sys.state == STATE_CHECK_MODE) { 
+    if (bit_istrue(settings.flags,BITFLAG_SOFT_LIMIT_ENABLE)) { limits_soft_check(target); }
+    return; 
+  }
+
+  #ifdef ENABLE_HEIGHT_MAP
+    if (height_map.enabled) { 
+      #ifdef USE_LINE_NUMBERS
+        mc_height_map_line(target, feed_rate, invert_feed_rate, line_number);
+      #else
+        mc_height_map_line(target, feed_rate, invert_feed_rate);
+      #endif
+      return;
+    }
+  #endif
+
+  #ifdef USE_LINE_NUMBERS
+    mc_queue_line(target, feed_rate, invert_feed_rate, line_number);
+  #else
+    mc_queue_line(target, feed_rate, invert_feed_rate);
+  #endif
+}
+
+
 // Execute an arc in offset mode format. position == current xyz, target == target xyz, 
 // offset == offset from current xyz, axis_X defines circle plane in tool space, axis_linear is
 // the direction of helical travel, radius == circle radius, isclockwise boolean. Used
@@ -93,6 +375,35 @@
     if (angular_travel <= ARC_ANGULAR_TRAVEL_EPSILON) { angular_travel += 2*M_PI; }
   }
 
+  // Check soft limits once against the arc bounding box, rather than on each segment, so an arc out
+  // of bounds is rejected as a whole before any of it is planned. The box spans the arc end points
+  // and each of the four quadrant points of the circle swept by the arc.
+  if (bit_istrue(settings.flags,BITFLAG_SOFT_LIMIT_ENABLE)) {
+    float arc_min[N_AXIS], arc_max[N_AXIS];
+    uint8_t idx;
+    for (idx=0; idx<N_AXIS; idx++) {
+      arc_min[idx] = min(position[idx],target[idx]);
+      arc_max[idx] = max(position[idx],target[idx]);
+    }
+    float start_angle = atan2(r_axis1,r_axis0);
+    for (idx=0; idx<4; idx++) {
+      // Angle from the start point to the quadrant point in the direction of travel.
+      float quadrant_travel = idx*(0.5*M_PI) - start_angle;
+      if (is_clockwise_arc) { quadrant_travel = -quadrant_travel; }
+      while (quadrant_travel < 0.0) { quadrant_travel += 2*M_PI; }
+      while (quadrant_travel >= 2*M_PI) { quadrant_travel -= 2*M_PI; }
+      if (quadrant_travel <= fabs(angular_travel)) {
+        switch (idx) {
+          case 0: arc_max[axis_0] = center_axis0 + radius; break;
+          case 1: arc_max[axis_1] = center_axis1 + radius; break;
+          case 2: arc_min[axis_0] = center_axis0 - radius; break;
+          default: arc_min[axis_1] = center_axis1 - radius;
+        }
+      }
+    }
+    if (limits_soft_check(arc_min) || limits_soft_check(arc_max)) { return; }
+  }
+
   // NOTE: Segment end points are on the arc, which can lead to the arc diameter being smaller by up to
   // (2x) settings.arc_tolerance. For 99% of users, this is just fine. If a different arc segment fit
   // is desired, i.e. least-squares, midpoint on arc, just change the mm_per_arc_segment calculation.
@@ -192,15 +503,11 @@ void mc_dwell(float seconds)
 {
    if (sys.state == STATE_CHECK_MODE) { return; }
    
-   uint16_t i = floor(1000/DWELL_TIME_STEP*seconds);
    protocol_buffer_synchronize();
-   delay_ms(floor(1000*seconds-i*DWELL_TIME_STEP)); //   .
-   while (i-- > 0) {
-     // .             <= DWELL_TIME_STEP .
-     protocol_execute_realtime();
-     if (sys.abort) { return; }
-     _delay_ms(DWELL_TIME_STEP); // Delay DWELL_TIME_STEP increment
-   }
+   // Time the dwell against the millisecond tick, rather than blocking here. Any following motions
+   // are still parsed and planned, but do not start until the dwell completes. Commands that need
+   // the dwell to complete first, like spindle and coolant changes, wait on the buffer sync.
+   system_set_delay(DELAY_DWELL, ceil(1000*seconds));
 }
 
 
@@ -248,6 +555,20 @@ void mc_homing_cycle()
   // Gcode parser position was circumvented by the limits_go_home() routine, so sync position now.
   gc_sync_position();
 
+  #ifdef ENABLE_BACKLASH_COMPENSATION
+    // Each homed axis finished with a pull-off motion away from its switch, which sets its direction.
+    // NOTE: Homing approaches in the negative direction when the homing direction mask bit is set.
+    uint8_t homed_mask = HOMING_CYCLE_0;
+    #ifdef HOMING_CYCLE_1
+      homed_mask |= HOMING_CYCLE_1;
+    #endif
+    #ifdef HOMING_CYCLE_2
+      homed_mask |= HOMING_CYCLE_2;
+    #endif
+    backlash_dir_mask = (backlash_dir_mask & ~homed_mask) | (~SETTINGS_HOMING_DIR_MASK & homed_mask);
+    backlash_known_mask |= homed_mask;
+  #endif
+
   // If hard limits feature enabled, re-enable hard limits pin change register after homing cycle.
   limits_init();
 }
@@ -256,11 +577,11 @@ void mc_homing_cycle()
 //     .  .
 // NOTE: Upon probe failure, the program will be stopped and placed into ALARM state.
 #ifdef USE_LINE_NUMBERS
-  void mc_probe_cycle(float *target, float feed_rate, uint8_t invert_feed_rate, uint8_t is_probe_away, 
-    uint8_t is_no_error, int32_t line_number)
+  void mc_probe_cycle(float *target, float feed_rate, uint8_t invert_feed_rate, float retract_distance,
+    uint8_t is_probe_away, uint8_t is_no_error, int32_t line_number)
 #else
-  void mc_probe_cycle(float *target, float feed_rate, uint8_t invert_feed_rate, uint8_t is_probe_away,
-    uint8_t is_no_error)
+  void mc_probe_cycle(float *target, float feed_rate, uint8_t invert_feed_rate, float retract_distance,
+    uint8_t is_probe_away, uint8_t is_no_error)
 #endif
 { 
   // TODO:    ,      .
@@ -281,45 +602,87 @@ void mc_homing_cycle()
   }
   if (sys.abort) { return; } // Return if system reset has been issued.
 
-  // Setup and queue probing motion. Auto cycle-start should not start the cycle.
-  #ifdef USE_LINE_NUMBERS
-    mc_line(target, feed_rate, invert_feed_rate, line_number);
-  #else
-    mc_line(target, feed_rate, invert_feed_rate);
-  #endif
+  // With a retract distance, the probing cycle has two stages. The first seeks the probe at the 
+  // programmed feed rate, retracts by the retract distance, and the second re-probes slowly for 
+  // a precise trigger position. Both run without returning to the host in between.
+  float start_position[N_AXIS];
+  system_convert_array_steps_to_mpos(start_position, sys.position);
+  uint8_t is_triggered;
+  for (;;) {
+    // Setup and queue probing motion. Auto cycle-start should not start the cycle.
+    #ifdef USE_LINE_NUMBERS
+      mc_line(target, feed_rate, invert_feed_rate, line_number);
+    #else
+      mc_line(target, feed_rate, invert_feed_rate);
+    #endif
+    if (sys.soft_limit) { return; } // Bail, if the probing motion was rejected by soft limits.
   
-  //       .
-  sys_probe_state = PROBE_ACTIVE;
+    // Arm the probe pin interrupt, which latches the position and cancels the motion on trigger.
+    probe_arm();
 
-  // Perform probing cycle. Wait here until probe is triggered or motion completes.
-  //    .     ,         .
-  bit_true_atomic(sys_rt_exec_state, EXEC_CYCLE_START);
-  do {
-    protocol_execute_realtime(); 
-    if (sys.abort) { return; } //     
-  } while (sys.state != STATE_IDLE);
+    // Perform probing cycle. Wait here until probe is triggered or motion completes.
+    //    .     ,         .
+    bit_true_atomic(sys_rt_exec_state, EXEC_CYCLE_START);
+    do {
+      protocol_execute_realtime(); 
+      if (sys.abort) { return; } //     
+    } while (sys.state != STATE_IDLE);
+    is_triggered = (sys_probe_state != PROBE_ACTIVE);
+    probe_disarm(); // Ensure probe state monitor is disabled.
+
+    // Reset the stepper and planner buffers to remove the remainder of the probe motion.
+    st_reset(); // Reest step segment buffer.
+    plan_reset(); // Reset planner buffer. Zero planner positions. Ensure probing motion is cleared.
+    plan_sync_position(); // Sync planner position to current machine position.
+    if (!is_triggered || (retract_distance <= 0.0)) { break; }
+
+    // Retract from the trigger position back towards the start at rapid rate. The retract is 
+    // limited to the distance traveled, and the probe must have cleared at its end.
+    float retract_target[N_AXIS], travel[N_AXIS];
+    float travel_distance = 0.0;
+    uint8_t idx;
+    for (idx=0; idx<N_AXIS; idx++) {
+      retract_target[idx] = system_convert_axis_steps_to_mpos(sys.probe_position, idx);
+      travel[idx] = retract_target[idx]-start_position[idx];
+      travel_distance += travel[idx]*travel[idx];
+    }
+    travel_distance = sqrt(travel_distance);
+    if (retract_distance < travel_distance) {
+      for (idx=0; idx<N_AXIS; idx++) { retract_target[idx] -= travel[idx]*(retract_distance/travel_distance); }
+    } else {
+      memcpy(retract_target, start_position, sizeof(start_position));
+    }
+    #ifdef USE_LINE_NUMBERS
+      mc_line(retract_target, -1.0, false, line_number);
+    #else
+      mc_line(retract_target, -1.0, false);
+    #endif
+    protocol_buffer_synchronize();
+    if (sys.abort) { return; } // Check for system abort
+    if (probe_get_state()) { // Probe still triggered. Fail the cycle.
+      is_triggered = false; 
+      break; 
+    }
+    retract_distance = 0.0; // Single second stage.
+    feed_rate *= PROBE_LOCATE_FEED_SCALAR;
+  }
   
   // Probing cycle complete!
   
   // Set state variables and error out, if the probe failed and cycle with error is enabled.
-  if (sys_probe_state == PROBE_ACTIVE) {
+  if (!is_triggered) {
     if (is_no_error) { memcpy(sys.probe_position, sys.position, sizeof(float)*N_AXIS); }
     else { bit_true_atomic(sys_rt_exec_alarm, EXEC_ALARM_PROBE_FAIL); }
   } else { 
     sys.probe_succeeded = true; // Indicate to system the probing cycle completed successfully.
   }
-  sys_probe_state = PROBE_OFF; // Ensure probe state monitor is disabled.
   protocol_execute_realtime();   // Check and execute run-time commands
   if (sys.abort) { return; } // Check for system abort
 
-  // Reset the stepper and planner buffers to remove the remainder of the probe motion.
-  st_reset(); // Reest step segment buffer.
-  plan_reset(); // Reset planner buffer. Zero planner positions. Ensure probing motion is cleared.
-  plan_sync_position(); // Sync planner position to current machine position.
-
   // TODO: Update the g-code parser code to not require this target calculation but uses a gc_sync_position() call.
   // NOTE: The target[] variable updated here will be sent back and synced with the g-code parser.
   system_convert_array_steps_to_mpos(target, sys.position);
+  mc_uncompensate_position(target);
 
   #ifdef MESSAGE_PROBE_COORDINATES
     // All done! Output the probe position as message.
@@ -328,6 +691,96 @@ void mc_homing_cycle()
 }
 
 
+// Plans and starts a jog motion. Jogs share the planner and stepper pipeline with normal motions,
+// so consecutive jogs blend through junctions. The motion starts right away, rather than waiting 
+// for a cycle start, and may be cancelled with a controlled deceleration by the jog cancel command.
+// NOTE: An out-of-bounds target is rejected with a status code, since a jog is interactive and 
+// should not throw the machine into an alarm.
+#ifdef USE_LINE_NUMBERS
+  uint8_t mc_jog_execute(float *target, float feed_rate, int32_t line_number)
+#else
+  uint8_t mc_jog_execute(float *target, float feed_rate)
+#endif
+{
+  if (bit_istrue(settings.flags,BITFLAG_SOFT_LIMIT_ENABLE)) {
+    if (limits_check_travel(target)) { return(STATUS_TRAVEL_EXCEEDED); }
+  }
+
+  uint8_t jog_cancel_count = sys.jog_cancel_count;
+  #ifdef USE_LINE_NUMBERS
+    mc_line(target, feed_rate, false, line_number);
+  #else
+    mc_line(target, feed_rate, false);
+  #endif
+  if (sys.abort) { return(STATUS_OK); }
+
+  // Cancelled while waiting on a full planner. The jog was dropped, and the parser is already synced
+  // to the stopped position. Pass that back as the target, instead of restarting the motion.
+  if (sys.jog_cancel_count != jog_cancel_count) {
+    memcpy(target, gc_state.position, sizeof(gc_state.position));
+    return(STATUS_OK);
+  }
+
+  // Begin the jog immediately. Later jogs are appended to the active motion by the planner.
+  if ((sys.state == STATE_IDLE) && (plan_get_current_block() != NULL)) {
+    sys.state = STATE_JOG;
+    st_prep_buffer();
+    st_wake_up();
+  }
+
+  // The planner may still reject the jog in step space, after rounding or a backlash pre-move, which
+  // the check above can't see. Nothing past the plan end was queued, so resync the parser to it.
+  if (sys.soft_limit) {
+    sys.soft_limit = false;
+    plan_get_planner_mpos(gc_state.position);
+    mc_uncompensate_position(gc_state.position);
+    return(STATUS_TRAVEL_EXCEEDED);
+  }
+  return(STATUS_OK);
+}
+
+
+#ifdef ENABLE_SPINDLE_SYNC
+// Executes a G33 spindle-synchronized motion. The feed rate is the thread pitch, the distance traveled 
+// per revolution, times the measured spindle speed. The motion is planned from a standstill and held 
+// until a spindle index pulse, so every pass of a thread starts at the same spindle angle and follows 
+// the same acceleration ramp.
+// NOTE: The feed rate is set when the pass starts. The spindle is expected to hold speed through it.
+#ifdef USE_LINE_NUMBERS
+  void mc_spindle_sync_line(float *target, float pitch, int32_t line_number)
+#else
+  void mc_spindle_sync_line(float *target, float pitch)
+#endif
+{
+  if (sys.state == STATE_CHECK_MODE) { return; }
+  protocol_buffer_synchronize(); // Start from rest, so the acceleration ramp is the same every pass.
+  if (sys.abort) { return; }
+
+  #ifdef USE_LINE_NUMBERS
+    mc_line(target, pitch*spindle_get_rpm(), false, line_number);
+  #else
+    mc_line(target, pitch*spindle_get_rpm(), false);
+  #endif
+  if (sys.abort || (plan_get_current_block() == NULL)) { return; }
+
+  // Prepare the first step segments ahead of time, so the steppers start right on the index pulse.
+  st_prep_buffer();
+  if (spindle_wait_for_index()) {
+    sys.state = STATE_CYCLE;
+    st_wake_up();
+  } else {
+    // Reset, alarm or hold while waiting. Discard the unstarted motion and pass back the current position.
+    st_reset();
+    plan_reset();
+    plan_sync_position();
+    system_convert_array_steps_to_mpos(target, sys.position);
+    mc_uncompensate_position(target);
+  }
+  protocol_execute_realtime();
+}
+#endif
+
+
 // Method to ready the system to reset by setting the realtime reset command and killing any
 // active processes in the system. This also checks if a system reset is issued while Grbl
 // is in a motion state. If so, kills the steppers and sets the system alarm to flag position
@@ -350,7 +803,7 @@ void mc_reset()
 	*/
   //  ,        ,   ,    .
   // .         ,     ,   go_idle  ,     ,     .
-    if ((sys.state & (STATE_CYCLE | STATE_HOMING)) || (sys.suspend == SUSPEND_ENABLE_HOLD)) {
+    if ((sys.state & (STATE_CYCLE | STATE_HOMING | STATE_JOG)) || (sys.suspend == SUSPEND_ENABLE_HOLD)) {
       if (sys.state == STATE_HOMING) { bit_true_atomic(sys_rt_exec_alarm, EXEC_ALARM_HOMING_FAIL); }
       else { bit_true_atomic(sys_rt_exec_alarm, EXEC_ALARM_ABORT_CYCLE); }
       st_go_idle(); // Force kill steppers. Position has likely been lost.
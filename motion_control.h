@@ -35,11 +35,56 @@ void mc_homing_cycle();
 
 //     .  .
 #ifdef USE_LINE_NUMBERS
-void mc_probe_cycle(float *target, float feed_rate, uint8_t invert_feed_rate, uint8_t is_probe_away,
-  uint8_t is_no_error, int32_t line_number);
+void mc_probe_cycle(float *target, float feed_rate, uint8_t invert_feed_rate, float retract_distance,
+  uint8_t is_probe_away, uint8_t is_no_error, int32_t line_number);
 #else
-void mc_probe_cycle(float *target, float feed_rate, uint8_t invert_feed_rate, uint8_t is_probe_away,
-  uint8_t is_no_error);
+void mc_probe_cycle(float *target, float feed_rate, uint8_t invert_feed_rate, float retract_distance,
+  uint8_t is_probe_away, uint8_t is_no_error);
+#endif
+
+// Plans a jog motion from the $J= command and starts it immediately. Returns a status code
+// instead of alarming when the target is outside of the machine travel.
+#ifdef USE_LINE_NUMBERS
+uint8_t mc_jog_execute(float *target, float feed_rate, int32_t line_number);
+#else
+uint8_t mc_jog_execute(float *target, float feed_rate);
+#endif
+
+// Plans a G33 spindle-synchronized motion and starts it on a spindle index pulse.
+#ifdef ENABLE_SPINDLE_SYNC
+  #ifdef USE_LINE_NUMBERS
+  void mc_spindle_sync_line(float *target, float pitch, int32_t line_number);
+  #else
+  void mc_spindle_sync_line(float *target, float pitch);
+  #endif
+#endif
+
+// Forgets the tracked backlash directions, so they are re-learned from the next motion of each axis.
+// Called whenever planned blocks are discarded.
+#ifdef ENABLE_BACKLASH_COMPENSATION
+  void mc_backlash_reset();
+#endif
+
+// Removes the height map Z compensation from a machine or plan position, giving the uncompensated
+// position the g-code parser works in. No effect without an enabled height map.
+void mc_uncompensate_position(float *position);
+
+// Height map of the surface for Z compensation. Probed by the $M= command.
+#ifdef ENABLE_HEIGHT_MAP
+typedef struct {
+  uint8_t enabled;                 // Flags a valid map, which line motions follow.
+  float origin[2];                 // Machine XY position of the first map point (mm)
+  float spacing[2];                // XY spacing of the map points (mm)
+  float inv_spacing[2];            // Reciprocal of the XY spacing (1/mm)
+  float z[HEIGHT_MAP_POINTS_Y][HEIGHT_MAP_POINTS_X]; // Height relative to the first map point (mm)
+} height_map_t;
+extern height_map_t height_map;
+
+// Probes the height map over an XY area from the current position. Returns a status code.
+uint8_t mc_height_map_probe(float *size, float depth, float feed_rate);
+
+// Clears the height map and disables Z compensation.
+void mc_height_map_clear();
 #endif
 
 //   .    ,       .
@@ -18,6 +18,10 @@ typedef struct {
                                      //   g-  ,   , 
                                      // . . ,     .
   float previous_unit_vec[N_AXIS];   //      
+  #ifdef ENABLE_BACKLASH_COMPENSATION
+    uint8_t backlash_motion;         // Flags the block being planned as a backlash take-up motion.
+  #endif
+  uint8_t program_motion;            // Flags the blocks being planned as g-code motions. See plan_set_program_motion().
   float previous_nominal_speed_sqr;  //      
 } planner_t;
 static planner_t pl;
@@ -113,6 +117,10 @@ static void planner_recalculate()
         
   // Bail. Can't do anything with one only one plan-able block.
   if (block_index == block_buffer_planned) { return; }
+  #ifdef ENABLE_PERFORMANCE_COUNTERS
+    perf.recalculate_count++;
+    perf.recalculate_blocks++; // Last block in buffer
+  #endif
       
   // Reverse Pass: Coarsely maximize all possible deceleration curves back-planning from the last
   // block in buffer. Cease planning when the last optimal planned or tail pointer is reached.
@@ -133,6 +141,9 @@ static void planner_recalculate()
       next = current;
       current = &block_buffer[block_index];
       block_index = plan_prev_block_index(block_index);
+      #ifdef ENABLE_PERFORMANCE_COUNTERS
+        perf.recalculate_blocks++;
+      #endif
 
       // Check if next block is the tail block(=planned block). If so, update current stepper parameters.
       if (block_index == block_buffer_tail) { st_update_plan_block_parameters(); } 
@@ -156,6 +167,9 @@ static void planner_recalculate()
   while (block_index != block_buffer_head) {
     current = next;
     next = &block_buffer[block_index];
+    #ifdef ENABLE_PERFORMANCE_COUNTERS
+      perf.recalculate_blocks++;
+    #endif
     
     // Any acceleration detected in the forward pass automatically moves the optimal planned
     // pointer forward, since everything before this is all optimal. In other words, nothing
@@ -186,6 +200,9 @@ void plan_reset()
   block_buffer_head = 0; // Empty = tail
   next_buffer_head = 1; // plan_next_block_index(block_buffer_head)
   block_buffer_planned = 0; // = block_buffer_tail;
+  #ifdef ENABLE_BACKLASH_COMPENSATION
+    mc_backlash_reset(); // Discarded blocks may have set axis directions the machine never took.
+  #endif
 }
 
 
@@ -207,6 +224,12 @@ plan_block_t *plan_get_current_block()
 }
 
 
+void plan_set_program_motion(uint8_t is_program_motion)
+{
+  pl.program_motion = is_program_motion;
+}
+
+
 float plan_get_exec_block_exit_speed()
 {
   uint8_t block_index = plan_next_block_index(block_buffer_tail);
@@ -248,6 +271,16 @@ uint8_t plan_check_full_buffer()
   #ifdef USE_LINE_NUMBERS
     block->line_number = line_number;
   #endif
+  #ifdef ENABLE_BACKLASH_COMPENSATION
+    block->is_backlash_motion = pl.backlash_motion;
+  #endif
+  if (pl.program_motion) {
+    block->outputs = PL_OUTPUT_SYNC | spindle_programmed.state | (coolant_programmed << PL_OUTPUT_COOLANT_SHIFT);
+    block->spindle_pwm = spindle_programmed.pwm;
+  } else {
+    block->outputs = 0;
+    block->spindle_pwm = 0;
+  }
 
   // Compute and store initial move distance data.
   // TODO: After this for-loop, we don't touch the stepper algorithm data. Might be a good idea
@@ -273,17 +306,17 @@ uint8_t plan_check_full_buffer()
       }
       block->step_event_count = max(block->step_event_count, block->steps[idx]);
       if (idx == A_MOTOR) {
-        delta_mm = (target_steps[X_AXIS]-pl.position[X_AXIS] + target_steps[Y_AXIS]-pl.position[Y_AXIS])/settings.steps_per_mm[idx];
+        delta_mm = (target_steps[X_AXIS]-pl.position[X_AXIS] + target_steps[Y_AXIS]-pl.position[Y_AXIS])*settings_inverse.mm_per_step[idx];
       } else if (idx == B_MOTOR) {
-        delta_mm = (target_steps[X_AXIS]-pl.position[X_AXIS] - target_steps[Y_AXIS]+pl.position[Y_AXIS])/settings.steps_per_mm[idx];
+        delta_mm = (target_steps[X_AXIS]-pl.position[X_AXIS] - target_steps[Y_AXIS]+pl.position[Y_AXIS])*settings_inverse.mm_per_step[idx];
       } else {
-        delta_mm = (target_steps[idx] - pl.position[idx])/settings.steps_per_mm[idx];
+        delta_mm = (target_steps[idx] - pl.position[idx])*settings_inverse.mm_per_step[idx];
       }
     #else
       target_steps[idx] = lround(target[idx]*settings.steps_per_mm[idx]);
       block->steps[idx] = labs(target_steps[idx]-pl.position[idx]);
       block->step_event_count = max(block->step_event_count, block->steps[idx]);
-      delta_mm = (target_steps[idx] - pl.position[idx])/settings.steps_per_mm[idx];
+      delta_mm = (target_steps[idx] - pl.position[idx])*settings_inverse.mm_per_step[idx];
     #endif
     unit_vec[idx] = delta_mm; // Store unit vector numerator. Denominator computed later.
         
@@ -294,13 +327,30 @@ uint8_t plan_check_full_buffer()
     block->millimeters += delta_mm*delta_mm;
   }
   block->millimeters = sqrt(block->millimeters); // Complete millimeters calculation with sqrt()
+
+  // Check soft limits against the precomputed step space travel and reject the block, if out of 
+  // bounds. Homing motions search beyond the travel, and backlash take-up motions do not change
+  // the machine position.
+  uint8_t check_soft_limits = (bit_istrue(settings.flags,BITFLAG_SOFT_LIMIT_ENABLE) && (sys.state != STATE_HOMING));
+  #ifdef ENABLE_BACKLASH_COMPENSATION
+    if (pl.backlash_motion) { check_soft_limits = false; }
+  #endif
+  if (check_soft_limits) {
+    if (limits_soft_check_steps(target_steps)) { return; }
+  }
   
   // Bail if this is a zero-length block. Highly unlikely to occur.
   if (block->step_event_count == 0) { return; } 
   
   // Adjust feed_rate value to mm/min depending on type of rate input (normal, inverse time, or rapids)
   // TODO: Need to distinguish a rapids vs feed move for overrides. Some flag of some sort.
-  if (feed_rate < 0) { feed_rate = SOME_LARGE_VALUE; } // Scaled down to absolute max/rapids rate later
+  if (feed_rate < 0) { 
+    feed_rate = SOME_LARGE_VALUE; // Scaled down to absolute max/rapids rate later
+    #ifdef VARIABLE_SPINDLE
+      // In laser mode, the laser is always off during rapids.
+      if (bit_istrue(settings.spindle_flags,BITFLAG_LASER_MODE)) { block->outputs &= ~PL_OUTPUT_SPINDLE_MASK; }
+    #endif
+  }
   else if (invert_feed_rate) { feed_rate *= block->millimeters; }
   if (feed_rate < MINIMUM_FEED_RATE) { feed_rate = MINIMUM_FEED_RATE; } // Prevents step generation round-off condition.
 
@@ -308,17 +358,21 @@ uint8_t plan_check_full_buffer()
   // down such that no individual axes maximum values are exceeded with respect to the line direction. 
   // NOTE: This calculation assumes all axes are orthogonal (Cartesian) and works with ABC-axes,
   // if they are also orthogonal/independent. Operates on the absolute value of the unit vector.
-  float inverse_unit_vec_value;
+  // The most limiting axis has the largest unit vector value over its limit, so the limits are
+  // applied with one divide each after the loop, using the reciprocal axis settings.
+  float abs_unit_vec_value;
+  float max_rate_scalar = 0.0; // Largest unit vector value over axis max rate.
+  float acceleration_scalar = 0.0; // Largest unit vector value over axis acceleration.
   float inverse_millimeters = 1.0/block->millimeters;  // Inverse millimeters to remove multiple float divides	
   float junction_cos_theta = 0;
   for (idx=0; idx<N_AXIS; idx++) {
     if (unit_vec[idx] != 0) {  // Avoid divide by zero.
       unit_vec[idx] *= inverse_millimeters;  // Complete unit vector calculation
-      inverse_unit_vec_value = fabs(1.0/unit_vec[idx]); // Inverse to remove multiple float divides.
+      abs_unit_vec_value = fabs(unit_vec[idx]);
 
-      // Check and limit feed rate against max individual axis velocities and accelerations
-      feed_rate = min(feed_rate,settings.max_rate[idx]*inverse_unit_vec_value);
-      block->acceleration = min(block->acceleration,settings.acceleration[idx]*inverse_unit_vec_value);
+      // Find the axis limiting the feed rate and acceleration the most.
+      max_rate_scalar = max(max_rate_scalar,abs_unit_vec_value*settings_inverse.inv_max_rate[idx]);
+      acceleration_scalar = max(acceleration_scalar,abs_unit_vec_value*settings_inverse.inv_acceleration[idx]);
 
       // Incrementally compute cosine of angle between previous and current path. Cos(theta) of the junction
       // between the current move and the previous move is simply the dot product of the two unit vectors, 
@@ -326,6 +380,10 @@ uint8_t plan_check_full_buffer()
       junction_cos_theta -= pl.previous_unit_vec[idx] * unit_vec[idx];
     }
   }
+
+  // Check and limit feed rate against max individual axis velocities and accelerations
+  feed_rate = min(feed_rate,1.0/max_rate_scalar);
+  block->acceleration = min(block->acceleration,1.0/acceleration_scalar);
   
   // TODO: Need to check this method handling zero junction speeds when starting from rest.
   if (block_buffer_head == block_buffer_tail) {
@@ -380,6 +438,13 @@ uint8_t plan_check_full_buffer()
   // Compute the junction maximum entry based on the minimum of the junction speed and neighboring nominal speeds.
   block->max_entry_speed_sqr = min(block->max_junction_speed_sqr, 
                                    min(block->nominal_speed_sqr,pl.previous_nominal_speed_sqr));
+  #ifdef ENABLE_PERFORMANCE_COUNTERS
+    // A block planned into an empty buffer starts from rest. Its zero junction speed is not a limit.
+    if ((block_buffer_head != block_buffer_tail) && 
+        (block->max_entry_speed_sqr < min(block->nominal_speed_sqr,pl.previous_nominal_speed_sqr))) { 
+      perf.junction_limited++; 
+    }
+  #endif
   
   // Update previous path unit_vector and nominal speed (squared)
   memcpy(pl.previous_unit_vec, unit_vec, sizeof(unit_vec)); // pl.previous_unit_vec[] = unit_vec[]
@@ -397,6 +462,35 @@ uint8_t plan_check_full_buffer()
 }
 
 
+#ifdef ENABLE_BACKLASH_COMPENSATION
+/* Add a backlash take-up motion. The block is planned like any other rapid, so it obeys the axis
+   velocity and acceleration limits and joins the plan at a proper junction speed. Afterwards, the
+   planner position is restored to the machine position before the move, so the next g-code motion 
+   is planned from where it would have been without compensation, and the block is flagged so the 
+   stepper does not count its steps into sys.position. The motors end up offset by the backlash, 
+   which is exactly the slack taken up by the reversal. 
+   NOTE: Only called from the main program, so the stepper segment generator cannot load the block
+   before it is flagged. */
+#ifdef USE_LINE_NUMBERS   
+  void plan_buffer_backlash_line(float *target, int32_t line_number) 
+#else
+  void plan_buffer_backlash_line(float *target) 
+#endif
+{
+  int32_t position[N_AXIS];
+  memcpy(position, pl.position, sizeof(pl.position));
+  pl.backlash_motion = true;
+  #ifdef USE_LINE_NUMBERS
+    plan_buffer_line(target, -1.0, false, line_number);
+  #else
+    plan_buffer_line(target, -1.0, false);
+  #endif
+  pl.backlash_motion = false;
+  memcpy(pl.position, position, sizeof(position));
+}
+#endif
+
+
 //    .    /  .
 void plan_sync_position()
 {
@@ -419,6 +513,17 @@ void plan_sync_position()
 }
 
 
+// Returns the planner position in absolute millimeters. Used by motion control to compare the next
+// line motion against the end of the plan, rather than the executing machine position.
+void plan_get_planner_mpos(float *target)
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    target[idx] = pl.position[idx]*settings_inverse.mm_per_step[idx];
+  }
+}
+
+
 //       .
 uint8_t plan_get_block_buffer_count()
 {
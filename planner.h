@@ -14,6 +14,14 @@
   #endif
 #endif
 
+// Block outputs, packed into one byte. The spindle state (SPINDLE_*) is in bits 0-1 and the coolant 
+// state (COOLANT_*) in bits 2-3. Only g-code motions carry them, flagged by PL_OUTPUT_SYNC. System 
+// motions, like homing, jogging, probing, and backlash take-up, leave the outputs as they are.
+#define PL_OUTPUT_SPINDLE_MASK 0x03
+#define PL_OUTPUT_COOLANT_MASK 0x0C
+#define PL_OUTPUT_COOLANT_SHIFT 2
+#define PL_OUTPUT_SYNC bit(7) // Set the outputs when the block begins.
+
 // This struct stores a linear movement of a g-code block motion with its critical "nominal" values
 // are as specified in the source g-code. 
 typedef struct {
@@ -36,6 +44,13 @@ typedef struct {
   #ifdef USE_LINE_NUMBERS
     int32_t line_number;
   #endif
+  #ifdef ENABLE_BACKLASH_COMPENSATION
+    uint8_t is_backlash_motion;  // Backlash take-up block. Steps are not counted in the machine position.
+  #endif
+
+  // Spindle and coolant outputs programmed for this block. Applied by the stepper when it begins.
+  uint8_t outputs;               // Packed spindle and coolant states. See PL_OUTPUT_* above.
+  SPINDLE_PWM_TYPE spindle_pwm;  // Zero for system motions.
 } plan_block_t;
 
       
@@ -51,6 +66,20 @@ void plan_reset();
   void plan_buffer_line(float *target, float feed_rate, uint8_t invert_feed_rate);
 #endif
 
+#ifdef ENABLE_BACKLASH_COMPENSATION
+  // Add a backlash take-up motion to target[N_AXIS] in absolute millimeters. Planned as a rapid,
+  // but does not move the planner position or the machine position.
+  #ifdef USE_LINE_NUMBERS
+    void plan_buffer_backlash_line(float *target, int32_t line_number);
+  #else
+    void plan_buffer_backlash_line(float *target);
+  #endif
+#endif
+
+// Flags the blocks planned from here on as g-code motions, which carry the programmed spindle and
+// coolant outputs. Set around the g-code feed, rapid, arc, and G33 motions only. Cleared by plan_reset().
+void plan_set_program_motion(uint8_t is_program_motion);
+
 // Called when the current block is no longer needed. Discards the block and makes the memory
 // availible for new blocks.
 void plan_discard_current_block();
@@ -67,6 +96,9 @@ float plan_get_exec_block_exit_speed();
 // Reset the planner position vector (in steps)
 void plan_sync_position();
 
+// Returns the planner position in absolute millimeters, i.e. the end of the last planned block.
+void plan_get_planner_mpos(float *target);
+
 // Reinitialize plan with a partially completed block
 void plan_cycle_reinitialize();
 
@@ -106,30 +106,13 @@ void printInteger(long n)
 }
 
 
-// Convert float to string by immediately converting to a long integer, which contains
-// more digits than a float. Number of decimal places, which are tracked by a counter,
-// may be set by the user. The integer is then efficiently converted to a string.
-// NOTE: AVR '%' and '/' integer operations are very efficient. Bitshifting speed-up 
-// techniques are actually just slightly slower. Found this out the hard way.
-void printFloat(float n, uint8_t decimal_places)
+// Prints an unsigned fixed-point value, given as an integer in units of the last decimal place.
+// Shared by the float and integer-only formatters.
+static void print_fixed_point(uint32_t a, uint8_t decimal_places)
 {
-  if (n < 0) {
-    serial_write('-');
-    n = -n;
-  }
-
-  uint8_t decimals = decimal_places;
-  while (decimals >= 2) { // Quickly convert values expected to be E0 to E-4.
-    n *= 100;
-    decimals -= 2;
-  }
-  if (decimals) { n *= 10; }
-  n += 0.5; // Add rounding factor. Ensures carryover through entire value.
-    
   // Generate digits backwards and store in string.
-  unsigned char buf[10]; 
+  unsigned char buf[11]; // Up to 10 digits and the decimal point.
   uint8_t i = 0;
-  uint32_t a = (long)n;  
   buf[decimal_places] = '.'; // Place decimal point, even if decimal places are zero.
   while(a > 0) {
     if (i == decimal_places) { i++; } // Skip decimal point location
@@ -150,6 +133,30 @@ void printFloat(float n, uint8_t decimal_places)
 }
 
 
+// Convert float to string by immediately converting to a long integer, which contains
+// more digits than a float. Number of decimal places, which are tracked by a counter,
+// may be set by the user. The integer is then efficiently converted to a string.
+// NOTE: AVR '%' and '/' integer operations are very efficient. Bitshifting speed-up 
+// techniques are actually just slightly slower. Found this out the hard way.
+void printFloat(float n, uint8_t decimal_places)
+{
+  if (n < 0) {
+    serial_write('-');
+    n = -n;
+  }
+
+  uint8_t decimals = decimal_places;
+  while (decimals >= 2) { // Quickly convert values expected to be E0 to E-4.
+    n *= 100;
+    decimals -= 2;
+  }
+  if (decimals) { n *= 10; }
+  n += 0.5; // Add rounding factor. Ensures carryover through entire value.
+    
+  print_fixed_point((long)n,decimal_places);
+}
+
+
 // Floating value printing handlers for special variables types used in Grbl and are defined
 // in the config.h.
 //  - CoordValue: Handles all position or coordinate values in inches or mm reporting.
@@ -174,6 +181,22 @@ void printFloat_RateValue(float n) {
 void printFloat_SettingValue(float n) { printFloat(n,N_DECIMAL_SETTINGVALUE); }
 
 
+// Integer-only counterpart of printFloat_CoordValue(), for positions already converted to the units
+// of the last printed digit by system_convert_axis_steps_to_coord_units(). Used by status reports.
+void printFixed_CoordValue(int32_t n) {
+  uint32_t a = n;
+  if (n < 0) {
+    serial_write('-');
+    a = -a;
+  }
+  if (bit_istrue(settings.flags,BITFLAG_REPORT_INCHES)) {
+    print_fixed_point(a,N_DECIMAL_COORDVALUE_INCH);
+  } else {
+    print_fixed_point(a,N_DECIMAL_COORDVALUE_MM);
+  }
+}
+
+
 // Debug tool to print free memory in bytes at the called point. 
 // NOTE: Keep commented unless using. Part of this function always gets compiled in.
 // void printFreeMemory()
@@ -184,3 +207,28 @@ void printFloat_SettingValue(float n) { printFloat(n,N_DECIMAL_SETTINGVALUE); }
 //   printInteger((int32_t)free);
 //   printString(" ");
 // }
+
+
+#ifdef REPORT_FORMAT_BENCHMARK
+// Benchmarks the integer-only position formatting against the float path, each including the step
+// conversion. Prints the position of axis 'idx' both ways, followed by the microseconds each took.
+// Waits for an empty TX buffer first. A position is only a few characters, so it fits in the buffer
+// and the timing excludes the transmission.
+void printBenchmarkCoordValue(int32_t *steps, uint8_t idx)
+{
+  while (serial_get_tx_buffer_count()) { } // Drained by the TX interrupt.
+  printPgmString(PSTR("[FMT:"));
+  uint32_t start_us = system_get_tick_us();
+  printFloat_CoordValue(system_convert_axis_steps_to_mpos(steps,idx));
+  uint32_t float_us = system_get_tick_us()-start_us;
+  printPgmString(PSTR(","));
+  start_us = system_get_tick_us();
+  printFixed_CoordValue(system_convert_axis_steps_to_coord_units(steps,idx,0));
+  uint32_t fixed_us = system_get_tick_us()-start_us;
+  printPgmString(PSTR(",Float:"));
+  print_uint32_base10(float_us);
+  printPgmString(PSTR("us,Fixed:"));
+  print_uint32_base10(fixed_us);
+  printPgmString(PSTR("us]\r\n"));
+}
+#endif
@@ -34,7 +34,15 @@ void printFloat_RateValue(float n);
 
 void printFloat_SettingValue(float n);
 
+// Integer-only counterpart of printFloat_CoordValue(), for positions in units of the last printed digit.
+void printFixed_CoordValue(int32_t n);
+
 // Debug tool to print free memory in bytes at the called point. Not used otherwise.
 void printFreeMemory();
 
+// Benchmarks the integer-only position formatting of axis 'idx' against printFloat(). Run by '$B'.
+#ifdef REPORT_FORMAT_BENCHMARK
+  void printBenchmarkCoordValue(int32_t *steps, uint8_t idx);
+#endif
+
 #endif
\ No newline at end of file
@@ -10,6 +10,9 @@
 // Инвертирует состояние пина датчика в зависимости от настроек пользователя и режима цикла зондирования.
 uint8_t probe_invert_mask;
 
+// Set by the stepper ISR while it updates the system position during a probing cycle.
+volatile uint8_t probe_position_lock;
+
 
 // Процедура инициализации контактов зонда.
 void probe_init() 
@@ -21,6 +24,25 @@ void probe_init()
     PROBE_PORT |= PROBE_MASK;    // Если в DDR 0 (вход), то в PORT выбирается тип входа: (0 - HiZ,) 1 - PullUp
   #endif
   // probe_configure_invert_mask(false); // Initialize invert mask. Not required. Updated when in-use.
+  probe_disarm(); // Disarm a probing cycle interrupted by a system abort.
+}
+
+
+// Arms the probe for a probing cycle. The probe pin shares the control pin change interrupt, which
+// calls the probe state monitor, and only interrupts on probe pin changes while armed.
+// NOTE: Requires the probe pin to be on the control pin port, as on the supported pin maps.
+void probe_arm()
+{
+  sys_probe_state = PROBE_ACTIVE;
+  CONTROL_PCMSK |= PROBE_MASK;
+}
+
+
+// Disarms the probe after a probing cycle.
+void probe_disarm()
+{
+  CONTROL_PCMSK &= ~PROBE_MASK;
+  sys_probe_state = PROBE_OFF;
 }
 
 
@@ -39,16 +61,26 @@ void probe_configure_invert_mask(uint8_t is_probe_away)
 uint8_t probe_get_state() { return((PROBE_PIN & PROBE_MASK) ^ probe_invert_mask); }
 
 
-// Monitors probe pin state and records the system position when detected. Called by the
-// stepper ISR per ISR tick.
-// NOTE: This function must be extremely efficient as to not bog down the stepper ISR.
+// Latches the system position as the probe position and stops the probing motion. Called by the 
+// probe state monitor, or by the stepper ISR for a latch deferred by the probe state monitor.
+void probe_latch_position()
+{
+  sys_probe_state = PROBE_OFF;
+  memcpy(sys.probe_position, sys.position, sizeof(sys.position));
+  bit_true(sys_rt_exec_state, EXEC_MOTION_CANCEL);
+}
+
+
+// Monitors probe pin state and records the system position when detected. Called by the control
+// pin change interrupt, so the position is latched as the probe triggers, rather than at the next 
+// stepper ISR tick. If the stepper ISR is in the middle of updating the position, the latch is
+// deferred to the stepper ISR, once the update is complete.
 void probe_state_monitor()
 {
   if (sys_probe_state == PROBE_ACTIVE) {
     if (probe_get_state()) {
-      sys_probe_state = PROBE_OFF;
-      memcpy(sys.probe_position, sys.position, sizeof(sys.position));
-      bit_true(sys_rt_exec_state, EXEC_MOTION_CANCEL);
+      if (probe_position_lock) { sys_probe_state = PROBE_DEFERRED; }
+      else { probe_latch_position(); }
     }
   }
-}
\ No newline at end of file
+}
@@ -6,9 +6,18 @@
 //,    .
 #define PROBE_OFF     0 //     . (   .)
 #define PROBE_ACTIVE  1 //    .
+#define PROBE_DEFERRED 2 // Triggered during a stepper ISR position update. Latched by the stepper ISR.
+
+// Set by the stepper ISR while it updates the system position during a probing cycle.
+extern volatile uint8_t probe_position_lock;
 
 //    .
 void probe_init();
+
+// Arms and disarms the probe pin interrupt for a probing cycle.
+void probe_arm();
+void probe_disarm();
+
 /*
 // Called by probe_init() and the mc_probe() routines. Sets up the probe pin invert mask to 
 // appropriately set the pin logic according to setting for normal-high/normal-low operation 
@@ -25,8 +34,11 @@ void probe_configure_invert_mask(uint8_t is_probe_away);
 uint8_t probe_get_state();
 
 // Monitors probe pin state and records the system position when detected. Called by the
-// stepper ISR per ISR tick.
-//          .   ISR   ISR.
+// control pin change interrupt.
+//          .      .
 void probe_state_monitor();
 
+// Latches the system position as the probe position and stops the probing motion.
+void probe_latch_position();
+
 #endif
@@ -10,7 +10,11 @@
 #define COMMENT_TYPE_SEMICOLON 2
 
 
+static uint32_t status_push_last_ms; // Millisecond tick of the last periodic status report.
 static char line[LINE_BUFFER_SIZE]; // ,    .  .
+#ifdef ENABLE_PERFORMANCE_COUNTERS
+  static uint8_t sync_pending; // Flags an intentional planner drain, which is not counted as an underrun.
+#endif
 
 
 // Directs and executes one line of formatted input from protocol_process. While mostly
@@ -38,6 +42,10 @@ static void protocol_execute_line(char *line)
     //   Grbl '$'
     report_status_message(system_execute_line(line));
     
+  } else if (sys.state == STATE_JOG) {
+    // Block g-code while jogging. The parser position is only synced when the jog ends.
+    report_status_message(STATUS_IDLE_ERROR);
+
   } else if (sys.state == STATE_ALARM) {
     //   - gcode. ,    .
     report_status_message(STATUS_ALARM_LOCK);
@@ -205,6 +213,8 @@ void protocol_execute_realtime()
       report_alarm_message(ALARM_PROBE_FAIL);
     } else if (rt_exec & EXEC_ALARM_HOMING_FAIL) {
       report_alarm_message(ALARM_HOMING_FAIL);
+    } else if (rt_exec & EXEC_ALARM_SPINDLE_SYNC) {
+      report_alarm_message(ALARM_SPINDLE_SYNC_FAIL);
     }
     // Halt everything upon a critical event flag. Currently hard and soft limits flag this.
     if (rt_exec & EXEC_CRITICAL_EVENT) {
@@ -227,6 +237,19 @@ void protocol_execute_realtime()
     bit_false_atomic(sys_rt_exec_alarm,0xFF); // Clear all alarm flags
   }
   
+  // Send a periodic status report, if due. With BITFLAG_RT_STATUS_PUSH_ON_CHANGE set, only when the 
+  // machine state or position changed since the last report.
+  // Polled against the millisecond tick, which wraps around safely in the unsigned difference.
+  if (settings.status_push_interval) {
+    uint32_t tick_ms = system_get_tick_ms();
+    if ((tick_ms - status_push_last_ms) >= settings.status_push_interval) {
+      status_push_last_ms = tick_ms;
+      if (bit_isfalse(settings.status_report_mask,BITFLAG_RT_STATUS_PUSH_ON_CHANGE) || report_status_changed()) {
+        report_realtime_status();
+      }
+    }
+  }
+
   // Check amd execute realtime commands
   rt_exec = sys_rt_exec_state; // Copy volatile sys_rt_exec_state.
   if (rt_exec) { // Enter only if any bit flag is true
@@ -242,6 +265,12 @@ void protocol_execute_realtime()
       report_realtime_status();
       bit_false_atomic(sys_rt_exec_state,EXEC_STATUS_REPORT);
     }
+    #ifdef ENABLE_BINARY_STATUS_REPORT
+      if (rt_exec & EXEC_BINARY_STATUS_REPORT) { 
+        report_binary_status();
+        bit_false_atomic(sys_rt_exec_state,EXEC_BINARY_STATUS_REPORT);
+      }
+    #endif
   
     // Execute hold states.
     // NOTE: The math involved to calculate the hold should be low enough for most, if not all, 
@@ -252,13 +281,19 @@ void protocol_execute_realtime()
       // TODO: CHECK MODE? How to handle this? Likely nothing, since it only works when IDLE and then resets Grbl.
                 
       // State check for allowable states for hold methods.
-      if ((sys.state == STATE_IDLE) || (sys.state & (STATE_CYCLE | STATE_HOMING | STATE_MOTION_CANCEL | STATE_HOLD | STATE_SAFETY_DOOR))) {
+      if ((sys.state == STATE_IDLE) || (sys.state & (STATE_CYCLE | STATE_HOMING | STATE_MOTION_CANCEL | STATE_HOLD | STATE_SAFETY_DOOR | STATE_JOG))) {
 
-        // If in CYCLE state, all hold states immediately initiate a motion HOLD.
-        if (sys.state == STATE_CYCLE) {
+        // If in CYCLE or JOG state, all hold states immediately initiate a motion HOLD.
+        if (sys.state & (STATE_CYCLE | STATE_JOG)) {
           st_update_plan_block_parameters(); // Notify stepper module to recompute for hold deceleration.
           sys.suspend = SUSPEND_ENABLE_HOLD; // Initiate holding cycle with flag.
         }
+        // A jog is never resumed. Any hold command decelerates it as a motion cancel and flags the 
+        // remaining jog motions to be flushed from the buffers once stopped.
+        if (sys.state == STATE_JOG) {
+          bit_true(rt_exec,EXEC_MOTION_CANCEL);
+          sys.suspend |= SUSPEND_JOG_CANCEL;
+        }
         // If IDLE, Grbl is not in motion. Simply indicate suspend ready state.
         if (sys.state == STATE_IDLE) { sys.suspend = SUSPEND_ENABLE_READY; }
         
@@ -267,14 +302,15 @@ void protocol_execute_realtime()
         if (rt_exec & EXEC_MOTION_CANCEL) {
           // MOTION_CANCEL only occurs during a CYCLE, but a HOLD and SAFETY_DOOR may been initiated beforehand
           // to hold the CYCLE. If so, only flag that motion cancel is complete.
-          if (sys.state == STATE_CYCLE) { sys.state = STATE_MOTION_CANCEL; }
+          if (sys.state & (STATE_CYCLE | STATE_JOG)) { sys.state = STATE_MOTION_CANCEL; }
           sys.suspend |= SUSPEND_MOTION_CANCEL; // Indicate motion cancel when resuming. Special motion complete.
         }
     
         // Execute a feed hold with deceleration, only during cycle.
         if (rt_exec & EXEC_FEED_HOLD) {
           // Block SAFETY_DOOR state from prematurely changing back to HOLD.
-          if (bit_isfalse(sys.state,STATE_SAFETY_DOOR)) { sys.state = STATE_HOLD; }
+          // Also block a jog cancel from changing to HOLD, since it does not wait for a resume.
+          if (bit_isfalse(sys.state,STATE_SAFETY_DOOR) && bit_isfalse(sys.suspend,SUSPEND_JOG_CANCEL)) { sys.state = STATE_HOLD; }
         }
   
         // Execute a safety door stop with a feed hold, only during a cycle, and disable spindle/coolant.
@@ -304,26 +340,29 @@ void protocol_execute_realtime()
         if ((sys.state == STATE_IDLE) || ((sys.state & (STATE_HOLD | STATE_MOTION_CANCEL)) && (sys.suspend & SUSPEND_ENABLE_READY))) {
           // Re-energize powered components, if disabled by SAFETY_DOOR.
           if (sys.suspend & SUSPEND_ENERGIZE) { 
-            // Delayed Tasks: Restart spindle and coolant, delay to power-up, then resume cycle.
-            if (gc_state.modal.spindle != SPINDLE_DISABLE) { 
-              spindle_set_state(gc_state.modal.spindle, gc_state.spindle_speed); 
-              delay_ms(SAFETY_DOOR_SPINDLE_DELAY); // TODO: Blocking function call. Need a non-blocking one eventually.
-            }
-            if (gc_state.modal.coolant != COOLANT_DISABLE) { 
-              coolant_set_state(gc_state.modal.coolant); 
-              delay_ms(SAFETY_DOOR_COOLANT_DELAY); // TODO: Blocking function call. Need a non-blocking one eventually.
-            }
+            // Delayed Tasks: Restart spindle and coolant and start the power-up delay. The cycle start
+            // is re-issued once the delay completes, which then resumes the cycle.
+            // NOTE: Restores the outputs of the interrupted block, not the parser state, since spindle 
+            // and coolant changes are queued with the motions and may not have been executed yet.
+            uint16_t restore_delay = 0;
+            if (spindle_restore()) { restore_delay = SAFETY_DOOR_SPINDLE_DELAY; }
+            if (coolant_restore()) { restore_delay += SAFETY_DOOR_COOLANT_DELAY; }
+            if (restore_delay) { system_set_delay(DELAY_DOOR_RESTORE, restore_delay); }
+            bit_false(sys.suspend,SUSPEND_ENERGIZE);
             // TODO: Install return to pre-park position.
           }
-          // Start cycle only if queued motions exist in planner buffer and the motion is not canceled.
-          if (plan_get_current_block() && bit_isfalse(sys.suspend,SUSPEND_MOTION_CANCEL)) {
-            sys.state = STATE_CYCLE;
-            st_prep_buffer(); // Initialize step segment buffer before beginning cycle.
-            st_wake_up();
-          } else { // Otherwise, do nothing. Set and resume IDLE state.
-            sys.state = STATE_IDLE;
+          // Block cycle start until any pending dwell or power-up delay completes.
+          if (!sys.delay) {
+            // Start cycle only if queued motions exist in planner buffer and the motion is not canceled.
+            if (plan_get_current_block() && bit_isfalse(sys.suspend,SUSPEND_MOTION_CANCEL)) {
+              sys.state = STATE_CYCLE;
+              st_prep_buffer(); // Initialize step segment buffer before beginning cycle.
+              st_wake_up();
+            } else { // Otherwise, do nothing. Set and resume IDLE state.
+              sys.state = STATE_IDLE;
+            }
+            sys.suspend = SUSPEND_DISABLE; // Break suspend state.
           }
-          sys.suspend = SUSPEND_DISABLE; // Break suspend state.
         }
       }    
       bit_false_atomic(sys_rt_exec_state,EXEC_CYCLE_START);
@@ -335,7 +374,17 @@ void protocol_execute_realtime()
     // cycle reinitializations. The stepper path should continue exactly as if nothing has happened.   
     // NOTE: EXEC_CYCLE_STOP is set by the stepper subsystem when a cycle or feed hold completes.
     if (rt_exec & EXEC_CYCLE_STOP) {
-      if (sys.state & (STATE_HOLD | STATE_SAFETY_DOOR) && !(sys.soft_limit)) {
+      // Jog cancel complete. Discard the remaining jog motions and resync positions to the stopped
+      // machine position. Unlike a probe or system reset, nothing else needs to be reinitialized.
+      if (sys.suspend & SUSPEND_JOG_CANCEL) {
+        st_reset(); // Reset step segment buffer.
+        plan_reset(); // Reset planner buffer. Clear the remainder of the jog motions.
+        plan_sync_position(); // Sync planner position to current machine position.
+        gc_sync_position(); // Sync g-code parser position to current machine position.
+        sys.jog_cancel_count++; // Drops a jog still waiting to be planned. See mc_queue_line().
+        bit_false(sys.suspend,SUSPEND_JOG_CANCEL);
+      }
+      if (sys.state & (STATE_HOLD | STATE_SAFETY_DOOR)) {
         // Hold complete. Set to indicate ready to resume.  Remain in HOLD or DOOR states until user
         // has issued a resume command or reset.
         if (sys.suspend & SUSPEND_ENERGIZE) { // De-energize system if safety door has been opened.
@@ -344,19 +393,43 @@ void protocol_execute_realtime()
         }
         bit_true(sys.suspend,SUSPEND_ENABLE_READY);
       } else { // Motion is complete. Includes CYCLE, HOMING, and MOTION_CANCEL states.
+        #ifdef ENABLE_PERFORMANCE_COUNTERS
+          // The planner ran dry while the host still had g-code waiting in the serial buffer.
+          if ((sys.state == STATE_CYCLE) && !sync_pending && serial_get_rx_buffer_count()) { perf.planner_underrun++; }
+        #endif
         sys.suspend = SUSPEND_DISABLE;
         sys.state = STATE_IDLE;
+        // Apply any spindle and coolant changes programmed after the last executed motion.
+        if (plan_get_current_block() == NULL) {
+          spindle_sync_idle();
+          coolant_set_output(coolant_programmed);
+        }
       }
       bit_false_atomic(sys_rt_exec_state,EXEC_CYCLE_STOP);
     }
     
   }
 
+  // Complete any pending non-blocking delay once its deadline has elapsed. Re-issue the cycle start
+  // to resume a safety door restore or to begin motions queued behind a dwell, but don't resume a
+  // feed hold issued during the dwell without an explicit user cycle start.
+  if (sys.delay && bit_isfalse(sys.delay,DELAY_SPINDLE_INDEX)) {
+    if (system_check_delay_elapsed()) {
+      if ((sys.delay & DELAY_DOOR_RESTORE) || (sys.state == STATE_IDLE)) { protocol_auto_cycle_start(); }
+      sys.delay = DELAY_NONE;
+      // Apply any spindle and coolant changes programmed during a dwell, if no motions follow it.
+      if ((sys.state == STATE_IDLE) && (plan_get_current_block() == NULL)) {
+        spindle_sync_idle();
+        coolant_set_output(coolant_programmed);
+      }
+    }
+  }
+
   // Overrides flag byte (sys.override) and execution should be installed here, since they 
   // are realtime and require a direct and controlled interface to the main stepper program.
 
   //   
-  if (sys.state & (STATE_CYCLE | STATE_HOLD | STATE_MOTION_CANCEL | STATE_SAFETY_DOOR | STATE_HOMING)) { st_prep_buffer(); }  
+  if (sys.state & (STATE_CYCLE | STATE_HOLD | STATE_MOTION_CANCEL | STATE_SAFETY_DOOR | STATE_HOMING | STATE_JOG)) { st_prep_buffer(); }  
   
   // If safety door was opened, actively check when safety door is closed and ready to resume.
   // NOTE: This unlocks the SAFETY_DOOR state to a HOLD state, such that CYCLE_START can activate a resume.
@@ -377,12 +450,18 @@ void protocol_execute_realtime()
 // during a synchronize call, if it should happen. Also, waits for clean cycle end.
 void protocol_buffer_synchronize()
 {
+  #ifdef ENABLE_PERFORMANCE_COUNTERS
+    sync_pending = true;
+  #endif
   // If system is queued, ensure cycle resumes if the auto start flag is present.
   protocol_auto_cycle_start();
   do {
     protocol_execute_realtime();   // Check and execute run-time commands
-    if (sys.abort) { return; } // Check for system abort
-  } while (plan_get_current_block() || (sys.state == STATE_CYCLE));
+    if (sys.abort) { break; } // Check for system abort
+  } while (plan_get_current_block() || (sys.state == STATE_CYCLE) || sys.delay);
+  #ifdef ENABLE_PERFORMANCE_COUNTERS
+    sync_pending = false;
+  #endif
 }
 
 
@@ -64,6 +64,22 @@ void report_status_message(uint8_t status_code)
           case STATUS_MAX_STEP_RATE_EXCEEDED: 
           printPgmString(PSTR("Step rate > 30kHz")); break;
         #endif      
+        #ifdef HOMING_CONCURRENT_AXES
+          case STATUS_HOMING_RATE_EXCEEDED:
+          printPgmString(PSTR("Homing step rate > ISR rate")); break;
+        #endif
+        #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+          case STATUS_SETTING_AMASS_OVERDRIVE:
+          printPgmString(PSTR("AMASS exceeds ISR budget")); break;
+        #endif
+        case STATUS_TRAVEL_EXCEEDED:
+        printPgmString(PSTR("Travel exceeded")); break;
+        case STATUS_INVALID_JOG_COMMAND:
+        printPgmString(PSTR("Invalid jog command")); break;
+        #ifdef VARIABLE_SPINDLE
+          case STATUS_SETTING_SPINDLE_TABLE:
+          printPgmString(PSTR("Spindle table not ascending")); break;
+        #endif
         // Common g-code parser errors.
         case STATUS_GCODE_MODAL_GROUP_VIOLATION:
         printPgmString(PSTR("Modal group violation")); break;
@@ -99,6 +115,8 @@ void report_alarm_message(int8_t alarm_code)
       printPgmString(PSTR("Probe fail")); break;
       case ALARM_HOMING_FAIL:
       printPgmString(PSTR("Homing fail")); break;
+      case ALARM_SPINDLE_SYNC_FAIL:
+      printPgmString(PSTR("Spindle sync fail")); break;
     }
   #endif
   printPgmString(PSTR("\r\n"));
@@ -155,7 +173,20 @@ void report_grbl_help() {
                         "$C (check gcode mode)\r\n"
                         "$X (kill alarm lock)\r\n"
                         "$H (run homing cycle)\r\n"
-                        "~ (cycle start)\r\n"
+                        "$J=line (jog)\r\n"));
+    #ifdef ENABLE_HEIGHT_MAP
+      printPgmString(PSTR("$M (view height map)\r\n"
+                          "$M=x,y,depth,feed (probe height map)\r\n"
+                          "$MC (clear height map)\r\n"));
+    #endif
+    #ifdef ENABLE_PERFORMANCE_COUNTERS
+      printPgmString(PSTR("$P (view performance counters)\r\n"
+                          "$PC (clear performance counters)\r\n"));
+    #endif
+    #ifdef REPORT_FORMAT_BENCHMARK
+      printPgmString(PSTR("$B (benchmark position formatting)\r\n"));
+    #endif
+    printPgmString(PSTR("~ (cycle start)\r\n"
                         "! (feed hold)\r\n"
                         "? (current status)\r\n"
                         "ctrl-x (reset Grbl)\r\n"));
@@ -187,6 +218,10 @@ void report_grbl_settings() {
     printPgmString(PSTR("\r\n$25=")); printFloat_SettingValue(settings.homing_seek_rate);
     printPgmString(PSTR("\r\n$26=")); print_uint8_base10(settings.homing_debounce_delay);
     printPgmString(PSTR("\r\n$27=")); printFloat_SettingValue(settings.homing_pulloff);
+    printPgmString(PSTR("\r\n$28=")); print_uint32_base10(settings.status_push_interval);
+    #ifdef VARIABLE_SPINDLE
+      printPgmString(PSTR("\r\n$32=")); print_uint8_base10(bit_istrue(settings.spindle_flags,BITFLAG_LASER_MODE));
+    #endif
     printPgmString(PSTR("\r\n"));
   #else      
     printPgmString(PSTR("$0=")); print_uint8_base10(settings.pulse_microseconds);
@@ -212,7 +247,58 @@ void report_grbl_settings() {
     printPgmString(PSTR(" (homing feed, mm/min)\r\n$25=")); printFloat_SettingValue(settings.homing_seek_rate);
     printPgmString(PSTR(" (homing seek, mm/min)\r\n$26=")); print_uint8_base10(settings.homing_debounce_delay);
     printPgmString(PSTR(" (homing debounce, msec)\r\n$27=")); printFloat_SettingValue(settings.homing_pulloff);
-    printPgmString(PSTR(" (homing pull-off, mm)\r\n"));
+    printPgmString(PSTR(" (homing pull-off, mm)\r\n$28=")); print_uint32_base10(settings.status_push_interval);
+    printPgmString(PSTR(" (status report interval, msec)\r\n"));
+    #ifdef VARIABLE_SPINDLE
+      printPgmString(PSTR("$32=")); print_uint8_base10(bit_istrue(settings.spindle_flags,BITFLAG_LASER_MODE));
+      printPgmString(PSTR(" (laser mode, bool)\r\n"));
+    #endif
+  #endif
+
+  // Print spindle PWM calibration table. Rpm points from $50 and their PWM duty cycles from $60.
+  #ifdef VARIABLE_SPINDLE
+    uint8_t point;
+    for (point=0; point<SPINDLE_PWM_TABLE_POINTS; point++) {
+      printPgmString(PSTR("$")); print_uint8_base10(50+point);
+      printPgmString(PSTR("=")); printFloat_SettingValue(settings.spindle_rpm_point[point]);
+      #ifndef REPORT_GUI_MODE
+        printPgmString(PSTR(" (spindle point ")); print_uint8_base10(point);
+        printPgmString(PSTR(", rpm)"));
+      #endif
+      printPgmString(PSTR("\r\n"));
+    }
+    for (point=0; point<SPINDLE_PWM_TABLE_POINTS; point++) {
+      printPgmString(PSTR("$")); print_uint8_base10(60+point);
+      printPgmString(PSTR("=")); printFloat_SettingValue(settings.spindle_pwm_point[point]);
+      #ifndef REPORT_GUI_MODE
+        printPgmString(PSTR(" (spindle point ")); print_uint8_base10(point);
+        printPgmString(PSTR(", pwm %)"));
+      #endif
+      printPgmString(PSTR("\r\n"));
+    }
+  #endif
+
+  // Print AMASS settings. Verbose mode adds the estimated peak ISR load of each level, which is its
+  // cutoff frequency over-driven by 2^level, as a rate and a share of AMASS_MAX_ISR_FREQUENCY.
+  #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+    printPgmString(PSTR("$40=")); print_uint8_base10(settings.amass_max_level);
+    #ifndef REPORT_GUI_MODE
+      printPgmString(PSTR(" (amass levels)"));
+    #endif
+    uint8_t level;
+    for (level=0; level<MAX_AMASS_LEVEL; level++) {
+      printPgmString(PSTR("\r\n$")); print_uint8_base10(41+level);
+      printPgmString(PSTR("=")); print_uint32_base10(settings.amass_cutoff_freq[level]);
+      #ifndef REPORT_GUI_MODE
+        uint32_t isr_freq = (uint32_t)settings.amass_cutoff_freq[level] << (level+1);
+        printPgmString(PSTR(" (amass L")); print_uint8_base10(level+1);
+        printPgmString(PSTR(" cutoff, Hz, isr ")); print_uint32_base10(isr_freq);
+        printPgmString(PSTR("Hz ")); print_uint32_base10((100*isr_freq)/AMASS_MAX_ISR_FREQUENCY);
+        if (level < settings.amass_max_level) { printPgmString(PSTR("%)")); }
+        else { printPgmString(PSTR("%, off)")); }
+      #endif
+    }
+    printPgmString(PSTR("\r\n"));
   #endif
   
   // Print axis settings
@@ -228,6 +314,7 @@ void report_grbl_settings() {
         case 1: printFloat_SettingValue(settings.max_rate[idx]); break;
         case 2: printFloat_SettingValue(settings.acceleration[idx]/(60*60)); break;
         case 3: printFloat_SettingValue(-settings.max_travel[idx]); break;
+        case 4: printFloat_SettingValue(settings.backlash[idx]); break;
       }
       #ifdef REPORT_GUI_MODE
         printPgmString(PSTR("\r\n"));
@@ -243,6 +330,7 @@ void report_grbl_settings() {
           case 1: printPgmString(PSTR(" max rate, mm/min")); break;
           case 2: printPgmString(PSTR(" accel, mm/sec^2")); break;
           case 3: printPgmString(PSTR(" max travel, mm")); break;
+          case 4: printPgmString(PSTR(" backlash, mm")); break;
         }      
         printPgmString(PSTR(")\r\n"));
       #endif
@@ -278,6 +366,62 @@ void report_probe_parameters()
 }
 
 
+#ifdef ENABLE_PERFORMANCE_COUNTERS
+// Prints the performance counters. The segment low-water mark reads SEGMENT_BUFFER_SIZE until a
+// motion has been streamed since the last clear.
+// NOTE: The counters are only updated from the main program, never from an interrupt.
+void report_perf_counters()
+{
+  printPgmString(PSTR("[PRF:Underrun:"));
+  print_uint32_base10(perf.planner_underrun);
+  printPgmString(PSTR(",SegLow:"));
+  print_uint8_base10(perf.segment_low_water);
+  printPgmString(PSTR(",FullMs:"));
+  print_uint32_base10(perf.planner_full_ms);
+  printPgmString(PSTR(",Recalc:"));
+  print_uint32_base10(perf.recalculate_count);
+  printPgmString(PSTR(",RecalcBlk:"));
+  print_uint32_base10(perf.recalculate_blocks);
+  printPgmString(PSTR(",JctLimit:"));
+  print_uint32_base10(perf.junction_limited);
+  printPgmString(PSTR("]\r\n"));
+}
+#endif
+
+
+// Prints the height map. The header lists the enabled state, the machine XY position of the first
+// map point, and the XY point spacing. Each following line is a row of heights along X, ordered
+// by Y, when the map is enabled.
+#ifdef ENABLE_HEIGHT_MAP
+void report_height_map()
+{
+  uint8_t i, j;
+  printPgmString(PSTR("[MAP:"));
+  print_uint8_base10(height_map.enabled);
+  for (i=X_AXIS; i<=Y_AXIS; i++) {
+    printPgmString(PSTR(","));
+    printFloat_CoordValue(height_map.origin[i]);
+  }
+  for (i=X_AXIS; i<=Y_AXIS; i++) {
+    printPgmString(PSTR(","));
+    printFloat_CoordValue(height_map.spacing[i]);
+  }
+  printPgmString(PSTR("]\r\n"));
+  if (!height_map.enabled) { return; }
+  for (j=0; j<HEIGHT_MAP_POINTS_Y; j++) {
+    printPgmString(PSTR("[MAP"));
+    print_uint8_base10(j);
+    printPgmString(PSTR(":"));
+    for (i=0; i<HEIGHT_MAP_POINTS_X; i++) {
+      printFloat_CoordValue(height_map.z[j][i]);
+      if (i < (HEIGHT_MAP_POINTS_X-1)) { printPgmString(PSTR(",")); }
+    }
+    printPgmString(PSTR("]\r\n"));
+  }
+}
+#endif
+
+
 // Prints Grbl NGC parameters (coordinate offsets, probing)
 void report_ngc_parameters()
 {
@@ -325,6 +469,9 @@ void report_gcode_modes()
     case MOTION_MODE_CW_ARC : printPgmString(PSTR("G2")); break;
     case MOTION_MODE_CCW_ARC : printPgmString(PSTR("G3")); break;
     case MOTION_MODE_NONE : printPgmString(PSTR("G80")); break;
+    #ifdef ENABLE_SPINDLE_SYNC
+      case MOTION_MODE_SPINDLE_SYNC : printPgmString(PSTR("G33")); break;
+    #endif
     default: 
       printPgmString(PSTR("G38."));
       print_uint8_base10(gc_state.modal.motion - (MOTION_MODE_PROBE_TOWARD-2));
@@ -414,6 +561,10 @@ void report_echo_line_received(char *line)
  // specific needs, but the desired real-time data report must be as short as possible. This is
  // requires as it minimizes the computational overhead and allows grbl to keep running smoothly, 
  // especially during g-code programs with fast, short line segments and high frequency reports (5-20Hz).
+// Machine state and position of the last realtime status report. Used to skip unchanged periodic reports.
+static uint8_t report_last_state;
+static int32_t report_last_position[N_AXIS];
+
 void report_realtime_status()
 {
   // **Under construction** Bare-bones status report. Provides real-time machine position relative to 
@@ -423,7 +574,8 @@ void report_realtime_status()
   uint8_t idx;
   int32_t current_position[N_AXIS]; // Copy current state of the system position variable
   memcpy(current_position,sys.position,sizeof(sys.position));
-  float print_position[N_AXIS];
+  report_last_state = sys.state;
+  memcpy(report_last_position,current_position,sizeof(current_position));
  
   // Report current machine state
   switch (sys.state) {
@@ -435,18 +587,16 @@ void report_realtime_status()
     case STATE_ALARM: printPgmString(PSTR("<Alarm")); break;
     case STATE_CHECK_MODE: printPgmString(PSTR("<Check")); break;
     case STATE_SAFETY_DOOR: printPgmString(PSTR("<Door")); break;
+    case STATE_JOG: printPgmString(PSTR("<Jog")); break;
   }
  
-  // If reporting a position, convert the current step count (current_position) to millimeters.
-  if (bit_istrue(settings.status_report_mask,(BITFLAG_RT_STATUS_MACHINE_POSITION | BITFLAG_RT_STATUS_WORK_POSITION))) {
-    system_convert_array_steps_to_mpos(print_position,current_position);
-  }
-  
-  // Report machine position
+  // Report machine position. Positions are converted from the current step count (current_position)
+  // straight to the units of the last printed digit. See printFixed_CoordValue().
+  // NOTE: Integer-only, since the float conversion and formatting are costly at high report rates.
   if (bit_istrue(settings.status_report_mask,BITFLAG_RT_STATUS_MACHINE_POSITION)) {
     printPgmString(PSTR(",MPos:")); 
     for (idx=0; idx< N_AXIS; idx++) {
-      printFloat_CoordValue(print_position[idx]);
+      printFixed_CoordValue(system_convert_axis_steps_to_coord_units(current_position,idx,0));
       if (idx < (N_AXIS-1)) { printPgmString(PSTR(",")); }
     }
   }
@@ -456,9 +606,7 @@ void report_realtime_status()
     printPgmString(PSTR(",WPos:")); 
     for (idx=0; idx< N_AXIS; idx++) {
       // Apply work coordinate offsets and tool length offset to current position.
-      print_position[idx] -= gc_state.coord_system[idx]+gc_state.coord_offset[idx];
-      if (idx == TOOL_LENGTH_OFFSET_AXIS) { print_position[idx] -= gc_state.tool_length_offset; }    
-      printFloat_CoordValue(print_position[idx]);
+      printFixed_CoordValue(system_convert_axis_steps_to_coord_units(current_position,idx,gc_state.work_offset[idx]));
       if (idx < (N_AXIS-1)) { printPgmString(PSTR(",")); }
     }
   }
@@ -476,14 +624,9 @@ void report_realtime_status()
   }
     
   #ifdef USE_LINE_NUMBERS
-    // Report current line number
+    // Report line number of the executing block
     printPgmString(PSTR(",Ln:")); 
-    int32_t ln=0;
-    plan_block_t * pb = plan_get_current_block();
-    if(pb != NULL) {
-      ln = pb->line_number;
-    } 
-    printInteger(ln);
+    printInteger(st_get_line_number());
   #endif
     
   #ifdef REPORT_REALTIME_RATE
@@ -497,6 +640,12 @@ void report_realtime_status()
     print_unsigned_int8(limits_get_state(),2,N_AXIS);
   }
   
+  #ifdef ENABLE_SPINDLE_SYNC
+    // Report measured spindle speed
+    printPgmString(PSTR(",RPM:"));
+    print_uint32_base10(spindle_get_rpm() + 0.5);
+  #endif
+
   #ifdef REPORT_CONTROL_PIN_STATE 
     printPgmString(PSTR(",Ctl:"));
     print_uint8_base2(CONTROL_PIN & CONTROL_MASK);
@@ -504,3 +653,36 @@ void report_realtime_status()
   
   printPgmString(PSTR(">\r\n"));
 }
+
+
+// Returns true, if the machine state or position changed since the last realtime status report.
+uint8_t report_status_changed()
+{
+  if (sys.state != report_last_state) { return(true); }
+  return(memcmp(report_last_position,sys.position,sizeof(sys.position)) != 0);
+}
+
+
+#ifdef ENABLE_BINARY_STATUS_REPORT
+// Sends the compact binary status frame. Same snapshot as the realtime status report, but with raw
+// step positions and no formatting. See report.h for the frame layout.
+void report_binary_status()
+{
+  uint8_t frame[BINARY_STATUS_FRAME_SIZE];
+  int32_t current_position[N_AXIS]; // Copy current state of the system position variable
+  memcpy(current_position,sys.position,sizeof(sys.position));
+
+  frame[0] = BINARY_STATUS_FRAME_START;
+  frame[1] = BINARY_STATUS_FRAME_SIZE;
+  frame[2] = sys.state;
+  frame[3] = plan_get_block_buffer_count();
+  frame[4] = serial_get_rx_buffer_count();
+  memcpy(&frame[5],current_position,sizeof(current_position)); // AVR is little-endian.
+
+  uint8_t idx;
+  uint8_t checksum = 0;
+  for (idx=1; idx<(BINARY_STATUS_FRAME_SIZE-1); idx++) { checksum ^= frame[idx]; }
+  frame[BINARY_STATUS_FRAME_SIZE-1] = checksum;
+  for (idx=0; idx<BINARY_STATUS_FRAME_SIZE; idx++) { serial_write(frame[idx]); }
+}
+#endif
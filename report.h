@@ -34,6 +34,11 @@
 #define STATUS_SOFT_LIMIT_ERROR 10
 #define STATUS_OVERFLOW 11
 #define STATUS_MAX_STEP_RATE_EXCEEDED 12
+#define STATUS_SETTING_AMASS_OVERDRIVE 13
+#define STATUS_TRAVEL_EXCEEDED 14
+#define STATUS_INVALID_JOG_COMMAND 15
+#define STATUS_SETTING_SPINDLE_TABLE 16
+#define STATUS_HOMING_RATE_EXCEEDED 17
 
 #define STATUS_GCODE_UNSUPPORTED_COMMAND 20
 #define STATUS_GCODE_MODAL_GROUP_VIOLATION 21
@@ -53,6 +58,7 @@
 #define STATUS_GCODE_NO_OFFSETS_IN_PLANE 35
 #define STATUS_GCODE_UNUSED_WORDS 36
 #define STATUS_GCODE_G43_DYNAMIC_AXIS_ERROR 37
+#define STATUS_GCODE_SPINDLE_NOT_RUNNING 38
 
 // Define Grbl alarm codes.
 #define ALARM_HARD_LIMIT_ERROR 1
@@ -60,6 +66,7 @@
 #define ALARM_ABORT_CYCLE 3
 #define ALARM_PROBE_FAIL 4
 #define ALARM_HOMING_FAIL 5
+#define ALARM_SPINDLE_SYNC_FAIL 6
 
 // Define Grbl feedback message codes.
 #define MESSAGE_CRITICAL_EVENT 1
@@ -95,12 +102,41 @@ void report_echo_line_received(char *line);
 // Prints realtime status report
 void report_realtime_status();
 
+// Returns true, if the machine state or position changed since the last realtime status report
+uint8_t report_status_changed();
+
+#ifdef ENABLE_BINARY_STATUS_REPORT
+  // Binary status frame layout. Multi-byte values are little-endian.
+  //   [0] BINARY_STATUS_FRAME_START
+  //   [1] Frame size in bytes, BINARY_STATUS_FRAME_SIZE
+  //   [2] Machine state, sys.state (STATE_XXX bitmask)
+  //   [3] Planner buffer block count
+  //   [4] Serial RX buffer byte count
+  //   [5] Machine position, int32 steps for each of the N_AXIS axes
+  //   [5+4*N_AXIS] Checksum, XOR of all preceding bytes after the start byte
+  #define BINARY_STATUS_FRAME_START 0xA5 // Outside 7-bit ASCII, so never part of a text response.
+  #define BINARY_STATUS_FRAME_SIZE (6+4*N_AXIS)
+
+  // Sends the binary status frame
+  void report_binary_status();
+#endif
+
 // Prints recorded probe position
 void report_probe_parameters();
 
 // Prints Grbl NGC parameters (coordinate offsets, probe)
 void report_ngc_parameters();
 
+// Prints the height map
+#ifdef ENABLE_HEIGHT_MAP
+void report_height_map();
+#endif
+
+#ifdef ENABLE_PERFORMANCE_COUNTERS
+  // Prints the performance counters
+  void report_perf_counters();
+#endif
+
 // Prints current g-code parser mode state
 void report_gcode_modes();
 
@@ -152,6 +152,12 @@ ISR(SERIAL_RX)
     case CMD_FEED_HOLD:     bit_true_atomic(sys_rt_exec_state, EXEC_FEED_HOLD); break; // Set as true
     case CMD_SAFETY_DOOR:   bit_true_atomic(sys_rt_exec_state, EXEC_SAFETY_DOOR); break; // Set as true
     case CMD_RESET:         mc_reset(); break; // Call motion control reset routine.
+    case CMD_JOG_CANCEL:    
+      if (sys.state & STATE_JOG) { bit_true_atomic(sys_rt_exec_state, EXEC_MOTION_CANCEL); } // Only cancels jogs.
+      break;
+    #ifdef ENABLE_BINARY_STATUS_REPORT
+      case CMD_BINARY_STATUS_REPORT: bit_true_atomic(sys_rt_exec_state, EXEC_BINARY_STATUS_REPORT); break;
+    #endif
     default: // Write character to buffer    
       next_head = serial_rx_buffer_head + 1;
       if (next_head == RX_BUFFER_SIZE) { next_head = 0; }
@@ -5,12 +5,55 @@
 #include "grbl.h"
 
 settings_t settings;
+settings_inverse_t settings_inverse;
+
+// EEPROM layout checks. Each settings copy and its CRC must fit below the next copy. Checked with a 
+// negative array size, since sizeof() isn't available to the preprocessor. The build info line 
+// must end within the 1KB EEPROM of the Atmega328p. Checked here, after LINE_BUFFER_SIZE is defined.
+typedef char settings_size_check[((sizeof(settings_t)+EEPROM_CHECKSUM_SIZE) <= 
+                                  (EEPROM_ADDR_GLOBAL_BACKUP-EEPROM_ADDR_GLOBAL)) ? 1 : -1];
+#if (EEPROM_ADDR_BUILD_INFO+EEPROM_LINE_SIZE) > 1024
+  #error "Build info line exceeds the 1KB EEPROM. Reduce LINE_BUFFER_SIZE or move EEPROM_ADDR_BUILD_INFO."
+#endif
+
+// RAM copy of the coordinate system and G28/G30 parameter data. Loaded and checksum validated once at 
+// initialization, so coordinate system switches and '$#' reports don't read the EEPROM. Records which
+// failed validation are flagged in coord_data_fail, reported once on read, and then reset to zero.
+static float coord_data_cache[SETTING_INDEX_NCOORD+1][N_AXIS];
+static uint8_t coord_data_fail;
+
+// Coordinate log record, as stored in the parameter block. See COORD_LOG_RECORD_SIZE.
+typedef struct {
+  uint8_t coord_select;
+  uint8_t sequence;
+  float coord_data[N_AXIS];
+} coord_record_t;
+
+static uint8_t coord_log_slot[SETTING_INDEX_NCOORD+1]; // Slot of the live record of each index.
+static uint8_t coord_log_sequence[SETTING_INDEX_NCOORD+1]; // Sequence number of the live record.
+static uint8_t coord_log_head; // Erased slot the next record is written to.
+
+#define coord_log_addr(slot) (EEPROM_ADDR_PARAMETERS+(slot)*COORD_LOG_RECORD_SIZE)
+
+
+// Returns the next free slot of the coordinate log after the given slot. Live records are skipped.
+static uint8_t settings_coord_log_next(uint8_t slot)
+{
+  uint8_t idx;
+  do {
+    if (++slot == COORD_LOG_N_RECORD) { slot = 0; }
+    for (idx=0; idx <= SETTING_INDEX_NCOORD; idx++) {
+      if (coord_log_slot[idx] == slot) { break; }
+    }
+  } while (idx <= SETTING_INDEX_NCOORD);
+  return(slot);
+}
 
 
 //      EEPROM
 void settings_store_startup_line(uint8_t n, char *line)
 {
-  uint32_t addr = n*(LINE_BUFFER_SIZE+1)+EEPROM_ADDR_STARTUP_BLOCK;
+  uint32_t addr = n*EEPROM_LINE_SIZE+EEPROM_ADDR_STARTUP_BLOCK;
   memcpy_to_eeprom_with_checksum(addr,(char*)line, LINE_BUFFER_SIZE);
 }
 
@@ -25,8 +68,23 @@ void settings_store_build_info(char *line)
 //       EEPROM
 void settings_write_coord_data(uint8_t coord_select, float *coord_data)
 {  
-  uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
-  memcpy_to_eeprom_with_checksum(addr,(char*)coord_data, sizeof(float)*N_AXIS);
+  // Skip the EEPROM write, if the stored record is valid and unchanged.
+  if (!(bit_istrue(coord_data_fail,bit(coord_select))) && 
+      !(memcmp(coord_data_cache[coord_select], coord_data, sizeof(float)*N_AXIS))) { return; }
+  memcpy(coord_data_cache[coord_select], coord_data, sizeof(float)*N_AXIS);
+  bit_false(coord_data_fail,bit(coord_select));
+
+  // Append the record at the log head. The next free slot is erased first to mark the new head, so 
+  // an interrupted write leaves the live record and the head intact.
+  coord_record_t record;
+  record.coord_select = coord_select;
+  record.sequence = ++coord_log_sequence[coord_select];
+  memcpy(record.coord_data, coord_data, sizeof(float)*N_AXIS);
+  uint8_t next_head = settings_coord_log_next(coord_log_head);
+  eeprom_put_char(coord_log_addr(next_head), COORD_LOG_EMPTY);
+  memcpy_to_eeprom_with_checksum(coord_log_addr(coord_log_head), (char*)&record, sizeof(coord_record_t));
+  coord_log_slot[coord_select] = coord_log_head;
+  coord_log_head = next_head;
 }  
 
 
@@ -35,6 +93,32 @@ void write_global_settings()
 {
   eeprom_put_char(0, SETTINGS_VERSION);
   memcpy_to_eeprom_with_checksum(EEPROM_ADDR_GLOBAL, (char*)&settings, sizeof(settings_t));
+  memcpy_to_eeprom_with_checksum(EEPROM_ADDR_GLOBAL_BACKUP, (char*)&settings, sizeof(settings_t));
+}
+
+
+// Updates the reciprocals of the axis settings. Called whenever the settings change.
+static void settings_update_inverse()
+{
+  uint8_t idx;
+  uint8_t decimals = N_DECIMAL_COORDVALUE_MM;
+  settings_inverse.coord_units_per_mm = 1.0;
+  if (bit_istrue(settings.flags,BITFLAG_REPORT_INCHES)) {
+    decimals = N_DECIMAL_COORDVALUE_INCH;
+    settings_inverse.coord_units_per_mm = INCH_PER_MM;
+  }
+  while (decimals--) { settings_inverse.coord_units_per_mm *= 10.0; }
+  float coord_units_per_step;
+  for (idx=0; idx<N_AXIS; idx++) {
+    settings_inverse.mm_per_step[idx] = 1.0/settings.steps_per_mm[idx];
+    settings_inverse.inv_max_rate[idx] = 1.0/settings.max_rate[idx];
+    settings_inverse.inv_acceleration[idx] = 1.0/settings.acceleration[idx];
+    coord_units_per_step = settings_inverse.coord_units_per_mm/settings.steps_per_mm[idx];
+    settings_inverse.coord_units_per_step_int[idx] = coord_units_per_step;
+    settings_inverse.coord_units_per_step_frac[idx] = 
+      (coord_units_per_step-settings_inverse.coord_units_per_step_int[idx])*4294967296.0;
+  }
+  gc_update_work_offset(); // Reported units follow $13.
 }
 
 
@@ -46,6 +130,7 @@ void settings_restore(uint8_t restore_flag) {
 	settings.step_invert_mask = DEFAULT_STEPPING_INVERT_MASK;
 	settings.dir_invert_mask = DEFAULT_DIRECTION_INVERT_MASK;
 	settings.status_report_mask = DEFAULT_STATUS_REPORT_MASK;
+	settings.status_push_interval = DEFAULT_STATUS_PUSH_INTERVAL;
 	settings.junction_deviation = DEFAULT_JUNCTION_DEVIATION;
 	settings.arc_tolerance = DEFAULT_ARC_TOLERANCE;
 	settings.homing_dir_mask = DEFAULT_HOMING_DIR_MASK;
@@ -53,6 +138,10 @@ void settings_restore(uint8_t restore_flag) {
 	settings.homing_seek_rate = DEFAULT_HOMING_SEEK_RATE;
 	settings.homing_debounce_delay = DEFAULT_HOMING_DEBOUNCE_DELAY;
 	settings.homing_pulloff = DEFAULT_HOMING_PULLOFF;
+	settings.amass_max_level = DEFAULT_AMASS_MAX_LEVEL;
+	settings.amass_cutoff_freq[0] = DEFAULT_AMASS_LEVEL1_CUTOFF;
+	settings.amass_cutoff_freq[1] = DEFAULT_AMASS_LEVEL2_CUTOFF;
+	settings.amass_cutoff_freq[2] = DEFAULT_AMASS_LEVEL3_CUTOFF;
 
 	settings.flags = 0;
 	if (DEFAULT_REPORT_INCHES) { settings.flags |= BITFLAG_REPORT_INCHES; }
@@ -61,6 +150,16 @@ void settings_restore(uint8_t restore_flag) {
 	if (DEFAULT_SOFT_LIMIT_ENABLE) { settings.flags |= BITFLAG_SOFT_LIMIT_ENABLE; }
 	if (DEFAULT_HARD_LIMIT_ENABLE) { settings.flags |= BITFLAG_HARD_LIMIT_ENABLE; }
 	if (DEFAULT_HOMING_ENABLE) { settings.flags |= BITFLAG_HOMING_ENABLE; }
+	settings.spindle_flags = 0;
+	if (DEFAULT_LASER_MODE) { settings.spindle_flags |= BITFLAG_LASER_MODE; }
+	#ifdef VARIABLE_SPINDLE
+	  // Default to a linear map, with points evenly spaced between the min and max spindle rpm.
+	  uint8_t point;
+	  for (point=0; point<SPINDLE_PWM_TABLE_POINTS; point++) {
+	    settings.spindle_rpm_point[point] = SPINDLE_MIN_RPM + point*((SPINDLE_MAX_RPM-SPINDLE_MIN_RPM)/(SPINDLE_PWM_TABLE_POINTS-1));
+	    settings.spindle_pwm_point[point] = point*(100.0/(SPINDLE_PWM_TABLE_POINTS-1));
+	  }
+	#endif
   
 	settings.steps_per_mm[X_AXIS] = DEFAULT_X_STEPS_PER_MM;
 	settings.steps_per_mm[Y_AXIS] = DEFAULT_Y_STEPS_PER_MM;
@@ -74,8 +173,19 @@ void settings_restore(uint8_t restore_flag) {
 	settings.max_travel[X_AXIS] = (-DEFAULT_X_MAX_TRAVEL);
 	settings.max_travel[Y_AXIS] = (-DEFAULT_Y_MAX_TRAVEL);
 	settings.max_travel[Z_AXIS] = (-DEFAULT_Z_MAX_TRAVEL);    
+	settings.backlash[X_AXIS] = DEFAULT_X_BACKLASH;
+	settings.backlash[Y_AXIS] = DEFAULT_Y_BACKLASH;
+	settings.backlash[Z_AXIS] = DEFAULT_Z_BACKLASH;
 
 	write_global_settings();
+	settings_update_inverse();
+	limits_update_soft_limits();
+	#ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+	  st_update_amass_cutoffs();
+	#endif
+	#ifdef VARIABLE_SPINDLE
+	  spindle_update_pwm_table();
+	#endif
   }
   
   if (restore_flag & SETTINGS_RESTORE_PARAMETERS) {
@@ -90,7 +200,7 @@ void settings_restore(uint8_t restore_flag) {
 	eeprom_put_char(EEPROM_ADDR_STARTUP_BLOCK, 0);
 	#endif
 	#if N_STARTUP_LINE > 1
-	eeprom_put_char(EEPROM_ADDR_STARTUP_BLOCK+(LINE_BUFFER_SIZE+1), 0);
+	eeprom_put_char(EEPROM_ADDR_STARTUP_BLOCK+EEPROM_LINE_SIZE, 0);
 	#endif
   }
   
@@ -101,7 +211,7 @@ void settings_restore(uint8_t restore_flag) {
 // Reads startup line from EEPROM. Updated pointed line string data.
 uint8_t settings_read_startup_line(uint8_t n, char *line)
 {
-  uint32_t addr = n*(LINE_BUFFER_SIZE+1)+EEPROM_ADDR_STARTUP_BLOCK;
+  uint32_t addr = n*EEPROM_LINE_SIZE+EEPROM_ADDR_STARTUP_BLOCK;
   if (!(memcpy_from_eeprom_with_checksum((char*)line, addr, LINE_BUFFER_SIZE))) {
     // Reset line with default value
     line[0] = 0; // Empty line
@@ -125,28 +235,62 @@ uint8_t settings_read_build_info(char *line)
 }
 
 
-// Read selected coordinate data from EEPROM. Updates pointed coord_data value.
+// Read selected coordinate data from the RAM copy. Updates pointed coord_data value.
 uint8_t settings_read_coord_data(uint8_t coord_select, float *coord_data)
 {
-  uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
-  if (!(memcpy_from_eeprom_with_checksum((char*)coord_data, addr, sizeof(float)*N_AXIS))) {
+  if (bit_istrue(coord_data_fail,bit(coord_select))) {
     //      
     clear_vector_float(coord_data); 
     settings_write_coord_data(coord_select,coord_data);
     return(false);
   }
+  memcpy(coord_data, coord_data_cache[coord_select], sizeof(float)*N_AXIS);
   return(true);
 }  
 
 
+// Scans the coordinate log into the RAM copy. Keeps the newest valid record of each index and flags 
+// indices without one. The log head is the erased slot, or the first free slot if there is none.
+static void settings_load_coord_data()
+{
+  coord_record_t record;
+  uint8_t slot, idx;
+  for (idx=0; idx <= SETTING_INDEX_NCOORD; idx++) {
+    clear_vector_float(coord_data_cache[idx]);
+    coord_log_slot[idx] = COORD_LOG_N_RECORD;
+    bit_true(coord_data_fail,bit(idx));
+  }
+  coord_log_head = COORD_LOG_N_RECORD;
+  for (slot=0; slot < COORD_LOG_N_RECORD; slot++) {
+    if (eeprom_get_char(coord_log_addr(slot)) == COORD_LOG_EMPTY) {
+      if (coord_log_head == COORD_LOG_N_RECORD) { coord_log_head = slot; }
+      continue;
+    }
+    if (!(memcpy_from_eeprom_with_checksum((char*)&record, coord_log_addr(slot), sizeof(coord_record_t)))) { continue; }
+    idx = record.coord_select;
+    if (idx > SETTING_INDEX_NCOORD) { continue; }
+    // Sequence numbers wrap, but records of the same index are never more than a log length apart.
+    if (bit_isfalse(coord_data_fail,bit(idx)) && ((int8_t)(record.sequence-coord_log_sequence[idx]) <= 0)) { continue; }
+    memcpy(coord_data_cache[idx], record.coord_data, sizeof(float)*N_AXIS);
+    coord_log_sequence[idx] = record.sequence;
+    coord_log_slot[idx] = slot;
+    bit_false(coord_data_fail,bit(idx));
+  }
+  if (coord_log_head == COORD_LOG_N_RECORD) { coord_log_head = settings_coord_log_next(COORD_LOG_N_RECORD-1); }
+}
+
+
 // Reads Grbl global settings struct from EEPROM.
 uint8_t read_global_settings() {
   // Check version-byte of eeprom
   uint8_t version = eeprom_get_char(0);
   if (version == SETTINGS_VERSION) {
-    // Read settings-record and check checksum
+    // Read settings-record and check checksum. Restore a corrupted record from its backup copy.
     if (!(memcpy_from_eeprom_with_checksum((char*)&settings, EEPROM_ADDR_GLOBAL, sizeof(settings_t)))) {
-      return(false);
+      if (!(memcpy_from_eeprom_with_checksum((char*)&settings, EEPROM_ADDR_GLOBAL_BACKUP, sizeof(settings_t)))) {
+        return(false);
+      }
+      memcpy_to_eeprom_with_checksum(EEPROM_ADDR_GLOBAL, (char*)&settings, sizeof(settings_t));
     }
   } else {
     return(false); 
@@ -155,6 +299,59 @@ uint8_t read_global_settings() {
 }
 
 
+#ifdef HOMING_CONCURRENT_AXES
+// Checks a homing rate (mm/min) against the concurrent homing stepper ISR, which steps each axis at 
+// most once per tick. A faster axis would silently home at HOMING_ISR_FREQUENCY instead.
+static uint8_t settings_check_homing_rate(float rate, float steps_per_mm)
+{
+  return(rate*steps_per_mm <= (HOMING_ISR_FREQUENCY*60.0));
+}
+
+
+// Checks a homing rate against every axis.
+static uint8_t settings_check_homing_rate_all(float rate)
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    if (!settings_check_homing_rate(rate, settings.steps_per_mm[idx])) { return(false); }
+  }
+  return(true);
+}
+#endif
+
+
+#ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+// Checks AMASS settings against the stepper ISR overdrive budget. Each enabled level must have a lower
+// cutoff frequency than the level before it, and its cutoff frequency multiplied by its ISR overdrive
+// factor (2^level) must not exceed AMASS_MAX_ISR_FREQUENCY. Disabled levels are not checked.
+static uint8_t settings_check_amass(uint8_t max_level, uint16_t *cutoff_freq)
+{
+  uint8_t idx;
+  for (idx=0; idx<max_level; idx++) {
+    if (cutoff_freq[idx] == 0) { return(false); }
+    if ((idx > 0) && (cutoff_freq[idx] >= cutoff_freq[idx-1])) { return(false); }
+    if (((uint32_t)cutoff_freq[idx] << (idx+1)) > AMASS_MAX_ISR_FREQUENCY) { return(false); }
+  }
+  return(true);
+}
+#endif
+
+
+#ifdef VARIABLE_SPINDLE
+// Checks the spindle PWM calibration table. The rpm points must be strictly ascending, so that every
+// table segment has a finite slope, and the PWM duty cycles may not exceed 100%.
+static uint8_t settings_check_spindle_table(float *rpm_point, float *pwm_point)
+{
+  uint8_t idx;
+  for (idx=0; idx<SPINDLE_PWM_TABLE_POINTS; idx++) {
+    if (pwm_point[idx] > 100.0) { return(false); }
+    if ((idx > 0) && (rpm_point[idx] <= rpm_point[idx-1])) { return(false); }
+  }
+  return(true);
+}
+#endif
+
+
 //        
 uint8_t settings_store_global_setting(uint8_t parameter, float value) {
   if (value < 0.0) { return(STATUS_NEGATIVE_VALUE); } 
@@ -171,6 +368,10 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
             #ifdef MAX_STEP_RATE_HZ
               if (value*settings.max_rate[parameter] > (MAX_STEP_RATE_HZ*60.0)) { return(STATUS_MAX_STEP_RATE_EXCEEDED); }
             #endif
+            #ifdef HOMING_CONCURRENT_AXES
+              if (!settings_check_homing_rate(settings.homing_seek_rate, value) || 
+                  !settings_check_homing_rate(settings.homing_feed_rate, value)) { return(STATUS_HOMING_RATE_EXCEEDED); }
+            #endif
             settings.steps_per_mm[parameter] = value;
             break;
           case 1:
@@ -181,6 +382,7 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
             break;
           case 2: settings.acceleration[parameter] = value*60*60; break; // Convert to mm/min^2 for grbl internal use.
           case 3: settings.max_travel[parameter] = -value; break;  // Store as negative for grbl internal use.
+          case 4: settings.backlash[parameter] = value; break;
         }
         break; // Exit while-loop after setting has been configured and proceed to the EEPROM write call.
       } else {
@@ -198,22 +400,26 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
         if (int_value < 3) { return(STATUS_SETTING_STEP_PULSE_MIN); }
         settings.pulse_microseconds = int_value; break;
       case 1: settings.stepper_idle_lock_time = int_value; break;
-      case 2: 
-        settings.step_invert_mask = int_value; 
-        st_generate_step_dir_invert_masks(); // Regenerate step and direction port invert masks.
-        break;
-      case 3: 
-        settings.dir_invert_mask = int_value; 
-        st_generate_step_dir_invert_masks(); // Regenerate step and direction port invert masks.
-        break;
-      case 4: // Reset to ensure change. Immediate re-init may cause problems.
-        if (int_value) { settings.flags |= BITFLAG_INVERT_ST_ENABLE; }
-        else { settings.flags &= ~BITFLAG_INVERT_ST_ENABLE; }
-        break;
-      case 5: // Reset to ensure change. Immediate re-init may cause problems.
-        if (int_value) { settings.flags |= BITFLAG_INVERT_LIMIT_PINS; }
-        else { settings.flags &= ~BITFLAG_INVERT_LIMIT_PINS; }
-        break;
+      #ifdef FIXED_MACHINE_PROFILE
+        case 2: case 3: case 4: case 5: return(STATUS_SETTING_DISABLED); // Fixed at compile-time.
+      #else
+        case 2: 
+          settings.step_invert_mask = int_value; 
+          st_generate_step_dir_invert_masks(); // Regenerate step and direction port invert masks.
+          break;
+        case 3: 
+          settings.dir_invert_mask = int_value; 
+          st_generate_step_dir_invert_masks(); // Regenerate step and direction port invert masks.
+          break;
+        case 4: // Reset to ensure change. Immediate re-init may cause problems.
+          if (int_value) { settings.flags |= BITFLAG_INVERT_ST_ENABLE; }
+          else { settings.flags &= ~BITFLAG_INVERT_ST_ENABLE; }
+          break;
+        case 5: // Reset to ensure change. Immediate re-init may cause problems.
+          if (int_value) { settings.flags |= BITFLAG_INVERT_LIMIT_PINS; }
+          else { settings.flags &= ~BITFLAG_INVERT_LIMIT_PINS; }
+          break;
+      #endif
       case 6: // Reset to ensure change. Immediate re-init may cause problems.
         if (int_value) { settings.flags |= BITFLAG_INVERT_PROBE_PIN; }
         else { settings.flags &= ~BITFLAG_INVERT_PROBE_PIN; }
@@ -243,42 +449,119 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
           settings.flags &= ~BITFLAG_SOFT_LIMIT_ENABLE; // Force disable soft-limits.
         }
         break;
-      case 23: settings.homing_dir_mask = int_value; break;
-      case 24: settings.homing_feed_rate = value; break;
-      case 25: settings.homing_seek_rate = value; break;
+      #ifdef FIXED_MACHINE_PROFILE
+        case 23: return(STATUS_SETTING_DISABLED); // Fixed at compile-time.
+      #else
+        case 23: settings.homing_dir_mask = int_value; break;
+      #endif
+      case 24: 
+        #ifdef HOMING_CONCURRENT_AXES
+          if (!settings_check_homing_rate_all(value)) { return(STATUS_HOMING_RATE_EXCEEDED); }
+        #endif
+        settings.homing_feed_rate = value; 
+        break;
+      case 25: 
+        #ifdef HOMING_CONCURRENT_AXES
+          if (!settings_check_homing_rate_all(value)) { return(STATUS_HOMING_RATE_EXCEEDED); }
+        #endif
+        settings.homing_seek_rate = value; 
+        break;
       case 26: settings.homing_debounce_delay = int_value; break;
       case 27: settings.homing_pulloff = value; break;
+      case 28: 
+        if (value > 65535.0) { return(STATUS_INVALID_STATEMENT); } // Exceeds uint16_t milliseconds.
+        settings.status_push_interval = trunc(value); 
+        break;
+      #ifdef VARIABLE_SPINDLE
+        case 32:
+          if (int_value) { settings.spindle_flags |= BITFLAG_LASER_MODE; }
+          else { settings.spindle_flags &= ~BITFLAG_LASER_MODE; }
+          break;
+      #endif
+      #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+        case 40: 
+          if (int_value > MAX_AMASS_LEVEL) { return(STATUS_INVALID_STATEMENT); }
+          if (!settings_check_amass(int_value, settings.amass_cutoff_freq)) { return(STATUS_SETTING_AMASS_OVERDRIVE); }
+          settings.amass_max_level = int_value;
+          break;
+        case 41: case 42: case 43: {
+          // Validate a copy of the cutoff table, so a rejected value never reaches the stepper.
+          if (value > AMASS_MAX_ISR_FREQUENCY) { return(STATUS_SETTING_AMASS_OVERDRIVE); }
+          uint16_t cutoff_freq[MAX_AMASS_LEVEL];
+          memcpy(cutoff_freq, settings.amass_cutoff_freq, sizeof(cutoff_freq));
+          cutoff_freq[parameter-41] = trunc(value);
+          if (!settings_check_amass(settings.amass_max_level, cutoff_freq)) { return(STATUS_SETTING_AMASS_OVERDRIVE); }
+          memcpy(settings.amass_cutoff_freq, cutoff_freq, sizeof(cutoff_freq));
+          break;
+        }
+      #endif
       default: 
+        #ifdef VARIABLE_SPINDLE
+          if ((parameter >= 50) && (parameter < 70) && ((parameter % 10) < SPINDLE_PWM_TABLE_POINTS)) {
+            // Validate a copy of the spindle table, so a rejected value never reaches the PWM output.
+            float rpm_point[SPINDLE_PWM_TABLE_POINTS];
+            float pwm_point[SPINDLE_PWM_TABLE_POINTS];
+            memcpy(rpm_point, settings.spindle_rpm_point, sizeof(rpm_point));
+            memcpy(pwm_point, settings.spindle_pwm_point, sizeof(pwm_point));
+            if (parameter < 60) { rpm_point[parameter-50] = value; }
+            else { pwm_point[parameter-60] = value; }
+            if (!settings_check_spindle_table(rpm_point, pwm_point)) { return(STATUS_SETTING_SPINDLE_TABLE); }
+            memcpy(settings.spindle_rpm_point, rpm_point, sizeof(rpm_point));
+            memcpy(settings.spindle_pwm_point, pwm_point, sizeof(pwm_point));
+            break;
+          }
+        #endif
         return(STATUS_INVALID_STATEMENT);
     }
   }
   write_global_settings();
+  settings_update_inverse();
+  limits_update_soft_limits();
+  #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+    st_update_amass_cutoffs();
+  #endif
+  #ifdef VARIABLE_SPINDLE
+    spindle_update_pwm_table();
+  #endif
   return(STATUS_OK);
 }
 
 
 //   
 void settings_init() {
+  settings_load_coord_data();
   if(!read_global_settings()) {
     report_status_message(STATUS_SETTING_READ_FAIL);
     settings_restore(SETTINGS_RESTORE_ALL); //     EEPROM.
     report_grbl_settings();
   }
-
-  // NOTE: Checking paramater data, startup lines, and build info string should be done here, 
-  // but it seems fairly redundant. Each of these can be manually checked and reset or restored.
-  // Check all parameter data into a dummy variable. If error, reset to zero, otherwise do nothing.
-  // float coord_data[N_AXIS];
-  // uint8_t i;
-  // for (i=0; i<=SETTING_INDEX_NCOORD; i++) {
-  //   if (!settings_read_coord_data(i, coord_data)) {
-  // 	report_status_message(STATUS_SETTING_READ_FAIL);
-  //   }
-  // }
+  #ifdef FIXED_MACHINE_PROFILE
+    // Report the fixed machine profile in place of any stored values.
+    settings.step_invert_mask = SETTINGS_STEP_INVERT_MASK;
+    settings.dir_invert_mask = SETTINGS_DIR_INVERT_MASK;
+    settings.homing_dir_mask = SETTINGS_HOMING_DIR_MASK;
+    if (SETTINGS_INVERT_ST_ENABLE) { settings.flags |= BITFLAG_INVERT_ST_ENABLE; }
+    else { settings.flags &= ~BITFLAG_INVERT_ST_ENABLE; }
+    if (SETTINGS_INVERT_LIMIT_PINS) { settings.flags |= BITFLAG_INVERT_LIMIT_PINS; }
+    else { settings.flags &= ~BITFLAG_INVERT_LIMIT_PINS; }
+  #endif
+  settings_update_inverse();
+  limits_update_soft_limits();
+  #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+    st_update_amass_cutoffs();
+  #endif
+  #ifdef VARIABLE_SPINDLE
+    spindle_update_pwm_table();
+  #endif
+
+  // NOTE: Parameter data is checked once above, when loaded into RAM. Checking startup lines and build 
+  // info string should be done here, but it seems fairly redundant. Each of these can be manually checked 
+  // and reset or restored.
   // NOTE: Startup lines are checked and executed by protocol_main_loop at the end of initialization.
 }
 
 
+#ifndef FIXED_MACHINE_PROFILE
 //          Grbl.
 uint8_t get_step_pin_mask(uint8_t axis_idx)
 {
@@ -304,3 +587,4 @@ uint8_t get_limit_pin_mask(uint8_t axis_idx)
   if ( axis_idx == Y_AXIS ) { return((1<<Y_LIMIT_BIT)); }
   return((1<<Z_LIMIT_BIT));
 }
+#endif
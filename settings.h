@@ -10,7 +10,7 @@
 
 // Version of the EEPROM data. Will be used to migrate existing data from older versions of Grbl
 // when firmware is upgraded. Always stored in byte 0 of eeprom
-#define SETTINGS_VERSION 9  // NOTE: Check settings_reset() when moving to next version.
+#define SETTINGS_VERSION 15  // NOTE: Check settings_reset() when moving to next version.
 
 // Define bit flag masks for the boolean settings in settings.flag.
 #define BITFLAG_REPORT_INCHES      bit(0)
@@ -22,12 +22,16 @@
 #define BITFLAG_INVERT_LIMIT_PINS  bit(6)
 #define BITFLAG_INVERT_PROBE_PIN   bit(7)
 
+// Define bit flag masks for the boolean spindle settings in settings.spindle_flags.
+#define BITFLAG_LASER_MODE         bit(0)
+
 // Define status reporting boolean enable bit flags in settings.status_report_mask
 #define BITFLAG_RT_STATUS_MACHINE_POSITION  bit(0)
 #define BITFLAG_RT_STATUS_WORK_POSITION     bit(1)
 #define BITFLAG_RT_STATUS_PLANNER_BUFFER    bit(2)
 #define BITFLAG_RT_STATUS_SERIAL_RX         bit(3)
 #define BITFLAG_RT_STATUS_LIMIT_PINS        bit(4)
+#define BITFLAG_RT_STATUS_PUSH_ON_CHANGE    bit(5) // Periodic reports only when state or position changed.
 
 // Define settings restore bitflags.
 #define SETTINGS_RESTORE_ALL 0xFF // All bitflags
@@ -38,12 +42,14 @@
 
 // Define EEPROM memory address location values for Grbl settings and parameters
 // NOTE: The Atmega328p has 1KB EEPROM. The upper half is reserved for parameters and
-// the startup script. The lower half contains the global settings and space for future 
-// developments.
+// the startup script. The lower half contains the global settings and its backup copy, which
+// restores the global settings if the first copy fails its CRC. Each copy must fit in 255 bytes.
 #define EEPROM_ADDR_GLOBAL         1U
+#define EEPROM_ADDR_GLOBAL_BACKUP  256U
 #define EEPROM_ADDR_PARAMETERS     512U
 #define EEPROM_ADDR_STARTUP_BLOCK  768U
 #define EEPROM_ADDR_BUILD_INFO     942U
+#define EEPROM_LINE_SIZE           (LINE_BUFFER_SIZE+EEPROM_CHECKSUM_SIZE) // Stored startup line and build info
 
 // Define EEPROM address indexing for coordinate parameters
 #define N_COORDINATE_SYSTEM 6  // Number of supported work coordinate systems (from index 1)
@@ -53,11 +59,34 @@
 #define SETTING_INDEX_G30    N_COORDINATE_SYSTEM+1  // Home position 2
 // #define SETTING_INDEX_G92    N_COORDINATE_SYSTEM+2  // Coordinate offset (G92.2,G92.3 not supported)
 
+// Coordinate parameters are stored as a log of records rotating through the parameter block, so 
+// repeated G10/G28.1/G30.1 writes are spread over all of its cells. A record holds the coordinate index,
+// a per-index sequence number and the coordinate data, followed by its CRC-16. The newest valid record of
+// each index is live. New records are written to free slots only, so a live record is never overwritten.
+#define COORD_LOG_RECORD_SIZE (2+4*N_AXIS+EEPROM_CHECKSUM_SIZE)
+#define COORD_LOG_N_RECORD    ((EEPROM_ADDR_STARTUP_BLOCK-EEPROM_ADDR_PARAMETERS)/COORD_LOG_RECORD_SIZE)
+#define COORD_LOG_EMPTY       0xff // Coordinate index of an erased record. Marks the log head.
+#if COORD_LOG_N_RECORD < (SETTING_INDEX_NCOORD+3)
+  #error "Parameter block too small for the coordinate log. Requires two free records."
+#endif
+
 // Define Grbl axis settings numbering scheme. Starts at START_VAL, every INCREMENT, over N_SETTINGS.
-#define AXIS_N_SETTINGS          4
+#ifdef ENABLE_BACKLASH_COMPENSATION
+  #define AXIS_N_SETTINGS        5
+#else
+  #define AXIS_N_SETTINGS        4
+#endif
 #define AXIS_SETTINGS_START_VAL  100 // NOTE: Reserving settings values >= 100 for axis settings. Up to 255.
 #define AXIS_SETTINGS_INCREMENT  10  // Must be greater than the number of axis settings
 
+// Define the number of Adaptive Multi-Axis Step Smoothing levels. The stepper Bresenham data is scaled
+// by this value at compile-time. The runtime AMASS settings may enable any number of levels up to it.
+#define MAX_AMASS_LEVEL 3
+
+// Define the number of points in the piecewise-linear spindle rpm to PWM calibration table. The rpm 
+// points are numbered from $50 and their PWM duty cycles (%) from $60, so no more than 10 points.
+#define SPINDLE_PWM_TABLE_POINTS 5
+
 // Global persistent settings (Stored from byte EEPROM_ADDR_GLOBAL onwards)
 typedef struct {
   // Axis settings
@@ -65,6 +94,7 @@ typedef struct {
   float max_rate[N_AXIS];
   float acceleration[N_AXIS];
   float max_travel[N_AXIS];
+  float backlash[N_AXIS]; // Take-up distance in mm inserted on each direction reversal.
 
   // Remaining Grbl settings
   uint8_t pulse_microseconds;
@@ -72,6 +102,7 @@ typedef struct {
   uint8_t dir_invert_mask;
   uint8_t stepper_idle_lock_time; // If max value 255, steppers do not disable.
   uint8_t status_report_mask; // Mask to indicate desired report data.
+  uint16_t status_push_interval; // Periodic status report interval (ms). Zero disables.
   float junction_deviation;
   float arc_tolerance;
   
@@ -82,9 +113,48 @@ typedef struct {
   float homing_seek_rate;
   uint16_t homing_debounce_delay;
   float homing_pulloff;
+
+  uint8_t spindle_flags; // Contains the boolean spindle settings. See BITFLAG_LASER_MODE.
+  #ifdef VARIABLE_SPINDLE
+    float spindle_rpm_point[SPINDLE_PWM_TABLE_POINTS]; // Calibration rpm points. Strictly ascending.
+    float spindle_pwm_point[SPINDLE_PWM_TABLE_POINTS]; // PWM duty cycle (%) output at each rpm point.
+  #endif
+
+  uint8_t amass_max_level; // Number of enabled AMASS levels. Zero disables step smoothing.
+  uint16_t amass_cutoff_freq[MAX_AMASS_LEVEL]; // Upper step frequency (Hz) of each AMASS level bin.
 } settings_t;
 extern settings_t settings;
 
+// Reciprocals of the axis settings, so the planner and position conversions multiply rather than 
+// divide. Derived in RAM whenever the settings are loaded or changed. Not stored in EEPROM.
+typedef struct {
+  float mm_per_step[N_AXIS];
+  float inv_max_rate[N_AXIS];
+  float inv_acceleration[N_AXIS];
+  // Fixed-point scale factors of the reported positions, in units of the last printed digit (um, or
+  // 0.1 mil in inches mode), so status reports format positions from steps without any float math.
+  uint32_t coord_units_per_step_int[N_AXIS];  // Integer part
+  uint32_t coord_units_per_step_frac[N_AXIS]; // Fraction part, in 1/2^32 units
+  float coord_units_per_mm;
+} settings_inverse_t;
+extern settings_inverse_t settings_inverse;
+
+// Settings tested in the stepper, limit and homing hot paths. With FIXED_MACHINE_PROFILE, these are
+// constants of the selected defaults.
+#ifdef FIXED_MACHINE_PROFILE
+  #define SETTINGS_STEP_INVERT_MASK  (DEFAULT_STEPPING_INVERT_MASK)
+  #define SETTINGS_DIR_INVERT_MASK   (DEFAULT_DIRECTION_INVERT_MASK)
+  #define SETTINGS_HOMING_DIR_MASK   (DEFAULT_HOMING_DIR_MASK)
+  #define SETTINGS_INVERT_ST_ENABLE  (DEFAULT_INVERT_ST_ENABLE)
+  #define SETTINGS_INVERT_LIMIT_PINS (DEFAULT_INVERT_LIMIT_PINS)
+#else
+  #define SETTINGS_STEP_INVERT_MASK  (settings.step_invert_mask)
+  #define SETTINGS_DIR_INVERT_MASK   (settings.dir_invert_mask)
+  #define SETTINGS_HOMING_DIR_MASK   (settings.homing_dir_mask)
+  #define SETTINGS_INVERT_ST_ENABLE  (bit_istrue(settings.flags,BITFLAG_INVERT_ST_ENABLE))
+  #define SETTINGS_INVERT_LIMIT_PINS (bit_istrue(settings.flags,BITFLAG_INVERT_LIMIT_PINS))
+#endif
+
 // Initialize the configuration subsystem (load settings from EEPROM)
 void settings_init();
 
@@ -106,20 +176,30 @@ void settings_store_build_info(char *line);
 // Reads build info user-defined string
 uint8_t settings_read_build_info(char *line);
 
-// Writes selected coordinate data to EEPROM
+// Writes selected coordinate data to RAM and queues the EEPROM write
 void settings_write_coord_data(uint8_t coord_select, float *coord_data);
 
-// Reads selected coordinate data from EEPROM
+// Reads selected coordinate data from the RAM copy loaded at initialization
 uint8_t settings_read_coord_data(uint8_t coord_select, float *coord_data);
 
-// Returns the step pin mask according to Grbl's internal axis numbering
-uint8_t get_step_pin_mask(uint8_t i);
-
-// Returns the direction pin mask according to Grbl's internal axis numbering
-uint8_t get_direction_pin_mask(uint8_t i);
-
-// Returns the limit pin mask according to Grbl's internal axis numbering
-uint8_t get_limit_pin_mask(uint8_t i);
+#ifdef FIXED_MACHINE_PROFILE
+  // Pin mask lookups expanded inline, so constant axis indices fold at compile-time.
+  #define get_step_pin_mask(i) \
+    (((i) == X_AXIS) ? (1<<X_STEP_BIT) : (((i) == Y_AXIS) ? (1<<Y_STEP_BIT) : (1<<Z_STEP_BIT)))
+  #define get_direction_pin_mask(i) \
+    (((i) == X_AXIS) ? (1<<X_DIRECTION_BIT) : (((i) == Y_AXIS) ? (1<<Y_DIRECTION_BIT) : (1<<Z_DIRECTION_BIT)))
+  #define get_limit_pin_mask(i) \
+    (((i) == X_AXIS) ? (1<<X_LIMIT_BIT) : (((i) == Y_AXIS) ? (1<<Y_LIMIT_BIT) : (1<<Z_LIMIT_BIT)))
+#else
+  // Returns the step pin mask according to Grbl's internal axis numbering
+  uint8_t get_step_pin_mask(uint8_t i);
+
+  // Returns the direction pin mask according to Grbl's internal axis numbering
+  uint8_t get_direction_pin_mask(uint8_t i);
+
+  // Returns the limit pin mask according to Grbl's internal axis numbering
+  uint8_t get_limit_pin_mask(uint8_t i);
+#endif
 
 
 #endif
@@ -5,6 +5,45 @@
 #include "grbl.h"
 
 
+spindle_output_t spindle_programmed;
+static spindle_output_t spindle_applied; // Last set outputs. Restored after a safety door stop.
+
+#ifdef VARIABLE_SPINDLE
+  // Fraction bits of the fixed-point PWM values in the lookup table. A full PWM range, shifted up by 
+  // these, still fits 24 bits, so a segment interpolation can't overflow its signed 32-bit products.
+  // Slopes always keep 16 fraction bits. With a 16-bit PWM, their low byte is multiplied separately.
+  #ifdef CPU_MAP_ATMEGA2560
+    #define PWM_TABLE_FRAC_BITS 8
+  #else
+    #define PWM_TABLE_FRAC_BITS 16
+  #endif
+  #define PWM_TABLE_BINS 8 // Equal rpm bins over the table, which index the table segment directly.
+
+  // Spindle PWM lookup table, precomputed from the calibration settings in whole rpm and fixed-point 
+  // PWM register units. Each bin holds the segment at its start, which only needs advancing when a
+  // table segment is narrower than a bin.
+  typedef struct {
+    uint32_t rpm[SPINDLE_PWM_TABLE_POINTS];     // Table points in whole rpm.
+    int32_t pwm[SPINDLE_PWM_TABLE_POINTS-1];    // PWM at the start of each segment.
+    int32_t slope[SPINDLE_PWM_TABLE_POINTS-1];  // PWM per rpm of each segment, 16 fraction bits.
+    SPINDLE_PWM_TYPE pwm_min;                   // Rounded PWM at the first table point.
+    SPINDLE_PWM_TYPE pwm_max;                   // Rounded PWM at the last table point.
+    uint8_t bin_shift;                          // Bin of an rpm is its distance from rpm[0] >> bin_shift.
+    uint8_t bin_segment[PWM_TABLE_BINS];
+  } spindle_pwm_table_t;
+  static spindle_pwm_table_t pwm_table;
+#endif
+
+#ifdef ENABLE_SPINDLE_SYNC
+  static volatile uint32_t index_tick;    // Microsecond tick of the last index pulse.
+  static volatile uint32_t index_tick_ms; // Millisecond tick of the last index pulse. For staleness only.
+  static volatile uint32_t index_period;  // Duration of the last revolution (usec). Zero if unknown.
+  static volatile uint8_t index_count;    // Counts index pulses. Wraps around.
+  static volatile uint8_t index_seen;     // Flags a recent index pulse, for a valid index_tick. (boolean)
+  static uint8_t index_pin_state;        // Last read state of the index input.
+#endif
+
+
 void spindle_init()
 {    
   // Configure variable spindle PWM and enable pin, if requried. On the Uno, PWM and enable are
@@ -19,13 +58,114 @@ void spindle_init()
     SPINDLE_ENABLE_DDR |= (1<<SPINDLE_ENABLE_BIT); // Configure as output pin.
   #endif
   
-  #ifndef USE_SPINDLE_DIR_AS_ENABLE_PIN
+  #if !defined(USE_SPINDLE_DIR_AS_ENABLE_PIN) && !defined(DISABLE_SPINDLE_DIRECTION_PIN)
     SPINDLE_DIRECTION_DDR |= (1<<SPINDLE_DIRECTION_BIT); // Configure as output pin.
   #endif
+  memset(&spindle_programmed, 0, sizeof(spindle_output_t)); // Set to SPINDLE_DISABLE
+  memset(&spindle_applied, 0, sizeof(spindle_output_t));
+
+  // Configure the index input on the control port, with the internal pull-up resistor. The sensor
+  // pulls it low once per revolution. Its pin change interrupt is enabled by system_init().
+  #ifdef ENABLE_SPINDLE_SYNC
+    CONTROL_DDR &= ~(1<<SPINDLE_INDEX_BIT);
+    CONTROL_PORT |= (1<<SPINDLE_INDEX_BIT);
+    CONTROL_PCMSK |= (1<<SPINDLE_INDEX_BIT);
+    index_pin_state = CONTROL_PIN & (1<<SPINDLE_INDEX_BIT);
+    index_period = 0;
+    index_seen = false;
+  #endif
   spindle_stop();
 }
 
 
+#ifdef ENABLE_SPINDLE_SYNC
+  // Called from the control pin change interrupt. Timestamps the falling edge of the index input
+  // and keeps the duration of the last revolution. The first pulse after a stop only starts timing.
+  void spindle_index_capture()
+  {
+    uint8_t pin_state = CONTROL_PIN & (1<<SPINDLE_INDEX_BIT);
+    if (pin_state == index_pin_state) { return; } // Change on another control pin.
+    index_pin_state = pin_state;
+    if (pin_state) { return; } // Rising edge. Ignore.
+    uint32_t tick_us = system_get_tick_us();
+    uint32_t tick_ms = system_get_tick_ms();
+    if (index_seen && ((tick_ms - index_tick_ms) < SPINDLE_INDEX_STALE_TIME)) { 
+      index_period = tick_us - index_tick; 
+    } else {
+      index_period = 0;
+    }
+    index_tick = tick_us;
+    index_tick_ms = tick_ms;
+    index_seen = true;
+    index_count++;
+  }
+
+
+  // Returns the measured spindle speed. Zero until two index pulses have been seen, and once no pulse 
+  // has been seen for SPINDLE_INDEX_STALE_TIME. The stale check uses the millisecond tick, so a stopped 
+  // spindle still reads zero after the microsecond tick wraps around.
+  float spindle_get_rpm()
+  {
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t seen = index_seen;
+    uint32_t period = index_period;
+    uint32_t elapsed = system_get_tick_us() - index_tick;
+    uint32_t elapsed_ms = system_get_tick_ms() - index_tick_ms;
+    if (seen && (elapsed_ms >= SPINDLE_INDEX_STALE_TIME)) { index_seen = seen = false; }
+    SREG = sreg;
+    if (!seen || (period == 0)) { return(0.0); }
+    // A slowing spindle is bounded by the time since its last pulse, so the speed decays towards zero 
+    // rather than holding the last measurement.
+    if (elapsed > period) { period = elapsed; }
+    return(60000000.0/period);
+  }
+
+
+  // Holds the queued G33 motion until the next index pulse, while still executing realtime commands.
+  // Cycle starts are blocked by the DELAY_SPINDLE_INDEX flag, so the motion is never started off the 
+  // index. A feed hold or safety door can't be resumed on the index either, so it fails the wait like 
+  // a timeout, with the spindle sync alarm.
+  uint8_t spindle_wait_for_index()
+  {
+    uint8_t count = index_count;
+    uint32_t timeout = system_get_tick_ms() + SPINDLE_SYNC_TIMEOUT;
+    sys.delay |= DELAY_SPINDLE_INDEX;
+    while (index_count == count) {
+      protocol_execute_realtime();
+      if (sys.abort || (sys.state == STATE_ALARM)) { break; }
+      if ((sys.state != STATE_IDLE) || ((int32_t)(system_get_tick_ms() - timeout) >= 0)) {
+        bit_true_atomic(sys_rt_exec_alarm, EXEC_ALARM_SPINDLE_SYNC);
+        break;
+      }
+    }
+    bit_false(sys.delay,DELAY_SPINDLE_INDEX);
+    return(index_count != count);
+  }
+
+
+  // Holds the program until the measured spindle speed is within SPINDLE_AT_SPEED_TOLERANCE of the 
+  // programmed speed. If it doesn't get there within SPINDLE_SYNC_TIMEOUT, the spindle is stopped
+  // and an alarm is issued, so no motion runs with a stalled or slipping spindle.
+  static void spindle_wait_at_speed(float rpm)
+  {
+    uint32_t timeout = system_get_tick_ms() + SPINDLE_SYNC_TIMEOUT;
+    float tolerance = rpm*(SPINDLE_AT_SPEED_TOLERANCE/100.0);
+    while (fabs(spindle_get_rpm() - rpm) > tolerance) {
+      protocol_execute_realtime();
+      if (sys.abort) { return; }
+      if ((int32_t)(system_get_tick_ms() - timeout) >= 0) {
+        spindle_programmed.state = SPINDLE_DISABLE;
+        spindle_set_output(SPINDLE_DISABLE, 0);
+        bit_true_atomic(sys_rt_exec_alarm, EXEC_ALARM_SPINDLE_SYNC);
+        protocol_execute_realtime();
+        return;
+      }
+    }
+  }
+#endif
+
+
 void spindle_stop()
 {
   // On the Uno, spindle enable and PWM are shared. Other CPUs have seperate enable pin.
@@ -48,8 +188,75 @@ void spindle_stop()
 }
 
 
-void spindle_set_state(uint8_t state, float rpm)
+#ifdef VARIABLE_SPINDLE
+  void spindle_update_pwm_table()
+  {
+    uint8_t idx;
+    float pwm_point[SPINDLE_PWM_TABLE_POINTS];
+    for (idx=0; idx<SPINDLE_PWM_TABLE_POINTS; idx++) {
+      pwm_table.rpm[idx] = lround(settings.spindle_rpm_point[idx]);
+      pwm_point[idx] = settings.spindle_pwm_point[idx]*(PWM_MAX_VALUE/100.0);
+    }
+    pwm_table.pwm_min = floor(pwm_point[0] + 0.5);
+    pwm_table.pwm_max = floor(pwm_point[SPINDLE_PWM_TABLE_POINTS-1] + 0.5);
+    uint32_t width;
+    for (idx=0; idx<SPINDLE_PWM_TABLE_POINTS-1; idx++) {
+      pwm_table.pwm[idx] = lround(pwm_point[idx]*(1UL<<PWM_TABLE_FRAC_BITS));
+      width = pwm_table.rpm[idx+1]-pwm_table.rpm[idx];
+      if (width) { pwm_table.slope[idx] = lround((pwm_point[idx+1]-pwm_point[idx])*65536.0/width); }
+      else { pwm_table.slope[idx] = 0; } // Points less than 1rpm apart. Always stepped over.
+    }
+
+    // Size the bins to cover the table, and map each to the segment holding its first rpm.
+    width = pwm_table.rpm[SPINDLE_PWM_TABLE_POINTS-1]-pwm_table.rpm[0];
+    pwm_table.bin_shift = 0;
+    while ((width >> pwm_table.bin_shift) >= PWM_TABLE_BINS) { pwm_table.bin_shift++; }
+    uint8_t segment = 0;
+    uint32_t bin_rpm;
+    for (idx=0; idx<PWM_TABLE_BINS; idx++) {
+      bin_rpm = pwm_table.rpm[0] + ((uint32_t)idx << pwm_table.bin_shift);
+      while ((segment < SPINDLE_PWM_TABLE_POINTS-2) && (bin_rpm >= pwm_table.rpm[segment+1])) { segment++; }
+      pwm_table.bin_segment[idx] = segment;
+    }
+  }
+
+
+  // Computes the PWM output value for the given spindle rpm by linear interpolation between the
+  // calibration table points. Speeds outside of the table are clamped to its end points. Apart from
+  // rounding the rpm, integer-only, with the table segment indexed by its rpm bin.
+  static SPINDLE_PWM_TYPE spindle_compute_pwm_value(float rpm)
+  {
+    SPINDLE_PWM_TYPE current_pwm;
+    if (rpm <= pwm_table.rpm[0]) { 
+      current_pwm = pwm_table.pwm_min; 
+    } else if (rpm >= pwm_table.rpm[SPINDLE_PWM_TABLE_POINTS-1]) { 
+      current_pwm = pwm_table.pwm_max; // Prevent integer overflow
+    } else {
+      uint32_t whole_rpm = rpm + 0.5;
+      uint8_t idx = pwm_table.bin_segment[(whole_rpm-pwm_table.rpm[0]) >> pwm_table.bin_shift];
+      while ((idx < SPINDLE_PWM_TABLE_POINTS-2) && (whole_rpm >= pwm_table.rpm[idx+1])) { idx++; }
+      int32_t delta_rpm = whole_rpm-pwm_table.rpm[idx];
+      #if PWM_TABLE_FRAC_BITS == 16
+        int32_t pwm = pwm_table.pwm[idx] + delta_rpm*pwm_table.slope[idx];
+      #else
+        int32_t pwm = pwm_table.pwm[idx] + delta_rpm*(pwm_table.slope[idx] >> 8) + 
+                      ((delta_rpm*(pwm_table.slope[idx] & 0xff)) >> 8);
+      #endif
+      current_pwm = (pwm + (1L<<(PWM_TABLE_FRAC_BITS-1))) >> PWM_TABLE_FRAC_BITS;
+    }
+    #ifdef MINIMUM_SPINDLE_PWM
+      if (current_pwm < MINIMUM_SPINDLE_PWM) { current_pwm = MINIMUM_SPINDLE_PWM; }
+    #endif
+    return(current_pwm);
+  }
+#endif
+
+
+void spindle_set_output(uint8_t state, SPINDLE_PWM_TYPE pwm_value)
 {
+  spindle_applied.state = state;
+  spindle_applied.pwm = pwm_value;
+
   // Halt or set spindle direction and rpm. 
   if (state == SPINDLE_DISABLE) {
 
@@ -57,7 +264,7 @@ void spindle_set_state(uint8_t state, float rpm)
 
   } else {
 
-    #ifndef USE_SPINDLE_DIR_AS_ENABLE_PIN
+    #if !defined(USE_SPINDLE_DIR_AS_ENABLE_PIN) && !defined(DISABLE_SPINDLE_DIRECTION_PIN)
       if (state == SPINDLE_ENABLE_CW) {
         SPINDLE_DIRECTION_PORT &= ~(1<<SPINDLE_DIRECTION_BIT);
       } else {
@@ -71,36 +278,20 @@ void spindle_set_state(uint8_t state, float rpm)
       	TCCRA_REGISTER = (1<<COMB_BIT) | (1<<WAVE1_REGISTER) | (1<<WAVE0_REGISTER);
         TCCRB_REGISTER = (TCCRB_REGISTER & 0b11111000) | 0x02 | (1<<WAVE2_REGISTER) | (1<<WAVE3_REGISTER); // set to 1/8 Prescaler
         OCR4A = 0xFFFF; // set the top 16bit value
-        uint16_t current_pwm;
       #else
         TCCRA_REGISTER = (1<<COMB_BIT) | (1<<WAVE1_REGISTER) | (1<<WAVE0_REGISTER);
         TCCRB_REGISTER = (TCCRB_REGISTER & 0b11111000) | 0x02; // set to 1/8 Prescaler
-        uint8_t current_pwm;
       #endif
-
-      if (rpm <= 0.0) { spindle_stop(); } // RPM should never be negative, but check anyway.
-      else {
-        #define SPINDLE_RPM_RANGE (SPINDLE_MAX_RPM-SPINDLE_MIN_RPM)
-        if ( rpm < SPINDLE_MIN_RPM ) { rpm = 0; } 
-        else { 
-          rpm -= SPINDLE_MIN_RPM; 
-          if ( rpm > SPINDLE_RPM_RANGE ) { rpm = SPINDLE_RPM_RANGE; } // Prevent integer overflow
-        }
-        current_pwm = floor( rpm*(PWM_MAX_VALUE/SPINDLE_RPM_RANGE) + 0.5);
-        #ifdef MINIMUM_SPINDLE_PWM
-          if (current_pwm < MINIMUM_SPINDLE_PWM) { current_pwm = MINIMUM_SPINDLE_PWM; }
-        #endif
-        OCR_REGISTER = current_pwm; // Set PWM pin output
+      OCR_REGISTER = pwm_value; // Set PWM pin output
     
-        // On the Uno, spindle enable and PWM are shared, unless otherwise specified.
-        #if defined(CPU_MAP_ATMEGA2560) || defined(USE_SPINDLE_DIR_AS_ENABLE_PIN) 
-          #ifdef INVERT_SPINDLE_ENABLE_PIN
-            SPINDLE_ENABLE_PORT &= ~(1<<SPINDLE_ENABLE_BIT);
-          #else
-            SPINDLE_ENABLE_PORT |= (1<<SPINDLE_ENABLE_BIT);
-          #endif
+      // On the Uno, spindle enable and PWM are shared, unless otherwise specified.
+      #if defined(CPU_MAP_ATMEGA2560) || defined(USE_SPINDLE_DIR_AS_ENABLE_PIN) 
+        #ifdef INVERT_SPINDLE_ENABLE_PIN
+          SPINDLE_ENABLE_PORT &= ~(1<<SPINDLE_ENABLE_BIT);
+        #else
+          SPINDLE_ENABLE_PORT |= (1<<SPINDLE_ENABLE_BIT);
         #endif
-      }
+      #endif
       
     #else
       // NOTE: Without variable spindle, the enable bit should just turn on or off, regardless
@@ -116,9 +307,73 @@ void spindle_set_state(uint8_t state, float rpm)
 }
 
 
+uint8_t spindle_restore()
+{
+  #ifdef VARIABLE_SPINDLE
+    // In laser mode, re-enable the output at zero power. The resumed segments set the laser power.
+    if (bit_istrue(settings.spindle_flags,BITFLAG_LASER_MODE)) {
+      spindle_set_output(spindle_applied.state, 0);
+      return(false); // No spin-up delay required.
+    }
+  #endif
+  spindle_set_output(spindle_applied.state, spindle_applied.pwm);
+  return(spindle_applied.state != SPINDLE_DISABLE);
+}
+
+
+void spindle_set_state(uint8_t state, float rpm)
+{
+  #ifdef VARIABLE_SPINDLE
+    if (rpm <= 0.0) { state = SPINDLE_DISABLE; } // RPM should never be negative, but check anyway.
+    spindle_set_output(state, spindle_compute_pwm_value(rpm));
+  #else
+    spindle_set_output(state, 0);
+  #endif
+}
+
+
 void spindle_run(uint8_t state, float rpm)
 {
   if (sys.state == STATE_CHECK_MODE) { return; }
-  protocol_buffer_synchronize(); // Empty planner buffer to ensure spindle is set when programmed.  
-  spindle_set_state(state, rpm);
+  #ifdef ENABLE_SPINDLE_SYNC
+    // A spindle starting from off or reversing must be at speed before the next motion. Drain the queued 
+    // motions first, so the change is applied right away, and wait on the measured speed below. Speed 
+    // changes and repeated M3/M4 on a running spindle keep the motions flowing like any other.
+    uint8_t wait_at_speed = (state != SPINDLE_DISABLE) && (rpm > 0.0) && (state != spindle_programmed.state);
+    #ifdef VARIABLE_SPINDLE
+      if (bit_istrue(settings.spindle_flags,BITFLAG_LASER_MODE)) { wait_at_speed = false; }
+    #endif
+    if (wait_at_speed) {
+      protocol_buffer_synchronize();
+      if (sys.abort) { return; }
+    }
+  #endif
+  // Update the programmed spindle state. Every block planned from here on carries it, and the stepper
+  // applies it when that block begins. This keeps the motions flowing through a spindle change, 
+  // instead of draining the planner buffer and stopping the machine.
+  #ifdef VARIABLE_SPINDLE
+    if (rpm <= 0.0) { state = SPINDLE_DISABLE; }
+    spindle_programmed.pwm = spindle_compute_pwm_value(rpm);
+  #endif
+  spindle_programmed.state = state;
+  // With no motions queued or executing and no pending dwell, there is nothing to order against. Apply
+  // it now. Otherwise, if no further motions follow, it is applied when the cycle or dwell completes.
+  // NOTE: In laser mode, the laser only fires with motion and is not enabled here.
+  if ((sys.state == STATE_IDLE) && (plan_get_current_block() == NULL) && !sys.delay) { spindle_sync_idle(); }
+  #ifdef ENABLE_SPINDLE_SYNC
+    if (wait_at_speed) { spindle_wait_at_speed(rpm); }
+  #endif
+}
+
+
+// Sets the spindle outputs to the programmed state, when no motions are executing. 
+void spindle_sync_idle()
+{
+  #ifdef VARIABLE_SPINDLE
+    if (bit_istrue(settings.spindle_flags,BITFLAG_LASER_MODE)) { 
+      spindle_set_output(SPINDLE_DISABLE, 0); 
+      return;
+    }
+  #endif
+  spindle_set_output(spindle_programmed.state, spindle_programmed.pwm);
 }
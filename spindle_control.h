@@ -23,15 +23,57 @@
 #define spindle_control_h 
 
 
+#ifdef CPU_MAP_ATMEGA2560
+  #define SPINDLE_PWM_TYPE uint16_t
+#else
+  #define SPINDLE_PWM_TYPE uint8_t
+#endif
+
+// Spindle output state. The programmed state is updated in g-code program order by spindle_run()
+// and is carried by each planner block, so the stepper applies it when the block begins executing.
+typedef struct {
+  uint8_t state;          // SPINDLE_DISABLE, SPINDLE_ENABLE_CW, or SPINDLE_ENABLE_CCW
+  SPINDLE_PWM_TYPE pwm;   // Precomputed PWM output value. Not used without variable spindle.
+} spindle_output_t;
+extern spindle_output_t spindle_programmed;
+
+
 // Initializes spindle pins and hardware PWM, if enabled.
 void spindle_init();
 
-// Sets spindle direction and spindle rpm via PWM, if enabled.
+// Precomputes the rpm to PWM lookup table from the spindle calibration settings. Called by the
+// settings module whenever the table is loaded or changed.
+void spindle_update_pwm_table();
+
+// Sets spindle direction and spindle rpm via PWM, if enabled. Queued in program order with the
+// planned motions, rather than waiting for the planner buffer to empty.
 void spindle_run(uint8_t direction, float rpm);
 
+// Immediately sets spindle direction and spindle rpm.
 void spindle_set_state(uint8_t state, float rpm);
 
+// Immediately sets the spindle outputs from a precomputed PWM value. No floating point math, so
+// that the stepper ISR may call it when a new planner block begins.
+void spindle_set_output(uint8_t state, SPINDLE_PWM_TYPE pwm_value);
+
+// Sets the spindle outputs to the programmed state while idle. Disables the laser in laser mode.
+void spindle_sync_idle();
+
+// Re-applies the last set spindle outputs after a spindle stop. Returns true if enabled.
+uint8_t spindle_restore();
+
 // Kills spindle.
 void spindle_stop();
 
+#ifdef ENABLE_SPINDLE_SYNC
+  // Timestamps spindle index pulses. Called from the control pin change interrupt.
+  void spindle_index_capture();
+
+  // Returns the spindle speed measured from the index pulses in rpm.
+  float spindle_get_rpm();
+
+  // Waits for the next spindle index pulse. Returns false, if a reset or alarm occurs first.
+  uint8_t spindle_wait_for_index();
+#endif
+
 #endif
@@ -20,13 +20,14 @@
 // timer, and the CPU overhead. Level 0 (no AMASS, normal operation) frequency bin starts at the 
 // Level 1 cutoff frequency and up to as fast as the CPU allows (over 30kHz in limited testing).
 // NOTE: AMASS cutoff frequency multiplied by ISR overdrive factor must not exceed maximum step frequency.
-// NOTE: Current settings are set to overdrive the ISR to no more than 16kHz, balancing CPU overhead
-// and timer accuracy.  Do not alter these settings unless you know what you are doing.
-#define MAX_AMASS_LEVEL 3
-// AMASS_LEVEL0: Normal operation. No AMASS. No upper cutoff frequency. Starts at LEVEL1 cutoff frequency.
-#define AMASS_LEVEL1 (F_CPU/8000) // Over-drives ISR (x2). Defined as F_CPU/(Cutoff frequency in Hz)
-#define AMASS_LEVEL2 (F_CPU/4000) // Over-drives ISR (x4)
-#define AMASS_LEVEL3 (F_CPU/2000) // Over-drives ISR (x8)
+// NOTE: The number of active levels and their cutoff frequencies are Grbl settings ($40-$43), which are
+// checked against the AMASS_MAX_ISR_FREQUENCY budget when stored. The Bresenham data is always scaled by 
+// the compile-time MAX_AMASS_LEVEL, so any number of runtime levels up to it remains exact.
+#ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+  // AMASS_LEVEL0: Normal operation. No AMASS. No upper cutoff frequency. Starts at LEVEL1 cutoff frequency.
+  // Cutoffs stored as F_CPU/(Cutoff frequency in Hz). Level n over-drives the ISR (x2^n).
+  static uint32_t amass_cutoff_cycles[MAX_AMASS_LEVEL];
+#endif
 
 
 // Stores the planner block Bresenham algorithm execution data for the segments in the segment 
@@ -39,9 +40,24 @@ typedef struct {
   uint8_t direction_bits;
   uint32_t steps[N_AXIS];
   uint32_t step_event_count;
+  #ifdef ENABLE_BACKLASH_COMPENSATION
+    uint8_t is_backlash_motion; // Steps the motors only. Not counted in the machine position.
+  #endif
+  uint8_t outputs;          // Planner block outputs (PL_OUTPUT_*), plus the ST_OUTPUT_PWM flag.
+  SPINDLE_PWM_TYPE spindle_pwm;
+  #ifdef REPORT_REALTIME_RATE
+    float rate_cycles;      // Feed rate (mm/min) times CPU cycles per step. Divided by the segment step timing.
+  #endif
+  #ifdef USE_LINE_NUMBERS
+    int32_t line_number;    // Line number of the planner block, reported while executing.
+  #endif
 } st_block_t;
 static st_block_t st_block_buffer[SEGMENT_BUFFER_SIZE-1];
 
+// Loads the segment spindle PWM. Set for g-code motions, and in laser mode for system motions, where 
+// the PWM is zero and keeps the laser off. Otherwise a system motion leaves the PWM as it is.
+#define ST_OUTPUT_PWM bit(6)
+
 // Primary stepper segment ring buffer. Contains small, short line segments for the stepper 
 // algorithm to execute, which are "checked-out" incrementally from the first block in the
 // planner buffer. Once "checked-out", the steps in the segments buffer cannot be modified by 
@@ -55,6 +71,9 @@ typedef struct {
   #else
     uint8_t prescaler;      // Without AMASS, a prescaler is required to adjust for slow timing.
   #endif
+  #ifdef VARIABLE_SPINDLE
+    SPINDLE_PWM_TYPE spindle_pwm; // Spindle PWM output. Scaled by segment speed in laser mode.
+  #endif
 } segment_t;
 static segment_t segment_buffer[SEGMENT_BUFFER_SIZE];
 
@@ -72,10 +91,20 @@ typedef struct {
   uint8_t step_pulse_time;  // Step pulse reset time after step rise
   uint8_t step_outbits;         // The next stepping-bits to be output
   uint8_t dir_outbits;
+  #ifdef ENABLE_DUAL_AXIS
+    uint8_t step_outbits_dual;  // The next stepping-bits of the dual axis second motor
+    #ifdef STEP_PULSE_DELAY
+      uint8_t step_bits_dual;   // Stores step_outbits_dual to complete the step pulse delay
+    #endif
+  #endif
   #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
     uint32_t steps[N_AXIS];
   #endif
 
+  #ifdef HOMING_CONCURRENT_AXES
+    uint8_t homing;         // Runs the homing step generator instead of the segment buffer.
+  #endif
+
   uint16_t step_count;       // Steps remaining in line segment motion  
   uint8_t exec_block_index; // Tracks the current st_block index. Change indicates new block.
   st_block_t *exec_block;   // Pointer to the block data for the segment being executed
@@ -83,14 +112,52 @@ typedef struct {
 } stepper_t;
 static stepper_t st;
 
+// Homing step generator data. Each axis steps from its own phase accumulator at its own rate, so 
+// the axes of a homing cycle move independently rather than along one Bresenham line.
+#ifdef HOMING_CONCURRENT_AXES
+  typedef struct {
+    uint16_t rate[N_AXIS];     // Step rate in 1/65536 steps per ISR tick. Zero stops the axis.
+    uint16_t counter[N_AXIS];  // Phase accumulators. An axis steps when its counter overflows.
+    uint8_t step_bits[N_AXIS]; // Step port pin mask of each axis.
+    uint8_t dir_bits[N_AXIS];  // Direction port pin mask of each axis.
+    uint8_t reverse;           // Axes moving in the negative direction. Bitflag by axis index.
+  } st_homing_t;
+  static st_homing_t homing;
+#endif
+
 // Step segment ring buffer indices
 static volatile uint8_t segment_buffer_tail;
 static uint8_t segment_buffer_head;
 static uint8_t segment_next_head;
 
 // Step and direction port invert masks. 
-static uint8_t step_port_invert_mask;
-static uint8_t dir_port_invert_mask;
+#ifdef FIXED_MACHINE_PROFILE
+  #define axis_invert_mask(mask,idx,pin) (bit_istrue(mask,bit(idx)) ? (pin) : 0)
+  #define step_port_invert_mask (axis_invert_mask(SETTINGS_STEP_INVERT_MASK,X_AXIS,1<<X_STEP_BIT) | \
+    axis_invert_mask(SETTINGS_STEP_INVERT_MASK,Y_AXIS,1<<Y_STEP_BIT) | axis_invert_mask(SETTINGS_STEP_INVERT_MASK,Z_AXIS,1<<Z_STEP_BIT))
+  #define dir_port_invert_mask (axis_invert_mask(SETTINGS_DIR_INVERT_MASK,X_AXIS,1<<X_DIRECTION_BIT) | \
+    axis_invert_mask(SETTINGS_DIR_INVERT_MASK,Y_AXIS,1<<Y_DIRECTION_BIT) | axis_invert_mask(SETTINGS_DIR_INVERT_MASK,Z_AXIS,1<<Z_DIRECTION_BIT))
+#else
+  static uint8_t step_port_invert_mask;
+  static uint8_t dir_port_invert_mask;
+#endif
+
+// The second motor of the dual axis steps with its axis, on its own step pin.
+#ifdef ENABLE_DUAL_AXIS
+  #define DUAL_STEP_MASK (1<<DUAL_STEP_BIT)
+  #if DUAL_AXIS_SELECT == X_AXIS
+    #define DUAL_AXIS_STEP_MASK (1<<X_STEP_BIT)
+  #elif DUAL_AXIS_SELECT == Y_AXIS
+    #define DUAL_AXIS_STEP_MASK (1<<Y_STEP_BIT)
+  #else
+    #define DUAL_AXIS_STEP_MASK (1<<Z_STEP_BIT)
+  #endif
+  #ifdef FIXED_MACHINE_PROFILE
+    #define step_port_invert_mask_dual axis_invert_mask(SETTINGS_STEP_INVERT_MASK,DUAL_AXIS_SELECT,DUAL_STEP_MASK)
+  #else
+    static uint8_t step_port_invert_mask_dual;
+  #endif
+#endif
 
 // Used to avoid ISR nesting of the "Stepper Driver Interrupt". Should never occur though.
 static volatile uint8_t busy;   
@@ -119,6 +186,10 @@ typedef struct {
   float exit_speed;       // Exit speed of executing block (mm/min)
   float accelerate_until; // Acceleration ramp end measured from end of block (mm)
   float decelerate_after; // Deceleration ramp start measured from end of block (mm)
+
+  #ifdef VARIABLE_SPINDLE
+    float laser_pwm_per_speed; // Laser mode PWM scalar. Block spindle PWM over nominal speed. (1/(mm/min))
+  #endif
 } st_prep_t;
 static st_prep_t prep;
 
@@ -167,13 +238,16 @@ static st_prep_t prep;
 void st_wake_up() 
 {
   // Enable stepper drivers.
-  if (bit_istrue(settings.flags,BITFLAG_INVERT_ST_ENABLE)) { STEPPERS_DISABLE_PORT |= (1<<STEPPERS_DISABLE_BIT); }
+  if (SETTINGS_INVERT_ST_ENABLE) { STEPPERS_DISABLE_PORT |= (1<<STEPPERS_DISABLE_BIT); }
   else { STEPPERS_DISABLE_PORT &= ~(1<<STEPPERS_DISABLE_BIT); }
 
-  if (sys.state & (STATE_CYCLE | STATE_HOMING)){
+  if (sys.state & (STATE_CYCLE | STATE_HOMING | STATE_JOG)){
     // Initialize stepper output bits
     st.dir_outbits = dir_port_invert_mask; 
     st.step_outbits = step_port_invert_mask;
+    #ifdef ENABLE_DUAL_AXIS
+      st.step_outbits_dual = step_port_invert_mask_dual;
+    #endif
     
     // Initialize step pulse timing from settings. Here to ensure updating after re-writing.
     #ifdef STEP_PULSE_DELAY
@@ -208,7 +282,7 @@ void st_go_idle()
     delay_ms(settings.stepper_idle_lock_time);
     pin_state = true; // Override. Disable steppers.
   }
-  if (bit_istrue(settings.flags,BITFLAG_INVERT_ST_ENABLE)) { pin_state = !pin_state; } // Apply pin invert.
+  if (SETTINGS_INVERT_ST_ENABLE) { pin_state = !pin_state; } // Apply pin invert.
   if (pin_state) { STEPPERS_DISABLE_PORT |= (1<<STEPPERS_DISABLE_BIT); }
   else { STEPPERS_DISABLE_PORT &= ~(1<<STEPPERS_DISABLE_BIT); }
 }
@@ -273,8 +347,14 @@ ISR(TIMER1_COMPA_vect)
   // Then pulse the stepping pins
   #ifdef STEP_PULSE_DELAY
     st.step_bits = (STEP_PORT & ~STEP_MASK) | st.step_outbits; // Store out_bits to prevent overwriting.
+    #ifdef ENABLE_DUAL_AXIS
+      st.step_bits_dual = (DUAL_STEP_PORT & ~DUAL_STEP_MASK) | st.step_outbits_dual;
+    #endif
   #else  // Normal operation
     STEP_PORT = (STEP_PORT & ~STEP_MASK) | st.step_outbits;
+    #ifdef ENABLE_DUAL_AXIS
+      DUAL_STEP_PORT = (DUAL_STEP_PORT & ~DUAL_STEP_MASK) | st.step_outbits_dual;
+    #endif
   #endif  
 
   // Enable step pulse reset timer so that The Stepper Port Reset Interrupt can reset the signal after
@@ -285,6 +365,35 @@ ISR(TIMER1_COMPA_vect)
   busy = true;
   sei(); // Re-enable interrupts to allow Stepper Port Reset Interrupt to fire on-time. 
          // NOTE: The remaining code in this ISR will finish before returning to main program.
+
+  #ifdef HOMING_CONCURRENT_AXES
+    // Homing step generator. Rates and directions are set by the homing cycle in limits.c.
+    if (st.homing) {
+      st.step_outbits = 0;
+      uint8_t idx;
+      for (idx=0; idx<N_AXIS; idx++) {
+        uint16_t counter = homing.counter[idx] + homing.rate[idx];
+        if (counter < homing.counter[idx]) { // Overflow. Step this axis.
+          st.step_outbits |= homing.step_bits[idx];
+          if (homing.reverse & bit(idx)) { sys.position[idx]--; }
+          else { sys.position[idx]++; }
+        }
+        homing.counter[idx] = counter;
+      }
+      #ifdef ENABLE_DUAL_AXIS
+        // Each side of the dual axis is locked out separately, as it finds its own switch.
+        st.step_outbits_dual = 0;
+        if (st.step_outbits & DUAL_AXIS_STEP_MASK) {
+          if (sys.homing_axis_lock_dual) { st.step_outbits_dual = DUAL_STEP_MASK; }
+          st.step_outbits &= (sys.homing_axis_lock | ~DUAL_AXIS_STEP_MASK);
+        }
+        st.step_outbits_dual ^= step_port_invert_mask_dual;
+      #endif
+      st.step_outbits ^= step_port_invert_mask;
+      busy = false;
+      return;
+    }
+  #endif
     
   // If there is no step segment, attempt to pop one from the stepper buffer
   if (st.exec_segment == NULL) {
@@ -309,7 +418,18 @@ ISR(TIMER1_COMPA_vect)
         
         // Initialize Bresenham line and distance counters
         st.counter_x = st.counter_y = st.counter_z = (st.exec_block->step_event_count >> 1);
+
+        // Apply the spindle and coolant outputs programmed for this block, exactly as it begins.
+        if (st.exec_block->outputs & PL_OUTPUT_SYNC) {
+          spindle_set_output(st.exec_block->outputs & PL_OUTPUT_SPINDLE_MASK, st.exec_block->spindle_pwm);
+          coolant_set_output((st.exec_block->outputs & PL_OUTPUT_COOLANT_MASK) >> PL_OUTPUT_COOLANT_SHIFT);
+        }
       }
+      #ifdef VARIABLE_SPINDLE
+        // Load the segment spindle PWM. Only differs from the block PWM in laser mode. No effect, 
+        // if the spindle is disabled, since the PWM output is then disconnected.
+        if (st.exec_block->outputs & ST_OUTPUT_PWM) { OCR_REGISTER = st.exec_segment->spindle_pwm; }
+      #endif
       st.dir_outbits = st.exec_block->direction_bits ^ dir_port_invert_mask; 
 
       #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
@@ -328,8 +448,10 @@ ISR(TIMER1_COMPA_vect)
   }
   
   
-  // Check probing state.
-  probe_state_monitor();
+  // While the probe is armed, its pin interrupt defers any position latch during the update below,
+  // so a partially updated position is never latched. Skipped entirely when no probe is armed.
+  uint8_t probe_armed = sys_probe_state;
+  if (probe_armed) { probe_position_lock = true; }
    
   // Reset step out bits.
   st.step_outbits = 0; 
@@ -343,8 +465,14 @@ ISR(TIMER1_COMPA_vect)
   if (st.counter_x > st.exec_block->step_event_count) {
     st.step_outbits |= (1<<X_STEP_BIT);
     st.counter_x -= st.exec_block->step_event_count;
+    #ifdef ENABLE_BACKLASH_COMPENSATION
+      if (!st.exec_block->is_backlash_motion) {
+    #endif
     if (st.exec_block->direction_bits & (1<<X_DIRECTION_BIT)) { sys.position[X_AXIS]--; }
     else { sys.position[X_AXIS]++; }
+    #ifdef ENABLE_BACKLASH_COMPENSATION
+      }
+    #endif
   }
   #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
     st.counter_y += st.steps[Y_AXIS];
@@ -354,8 +482,14 @@ ISR(TIMER1_COMPA_vect)
   if (st.counter_y > st.exec_block->step_event_count) {
     st.step_outbits |= (1<<Y_STEP_BIT);
     st.counter_y -= st.exec_block->step_event_count;
+    #ifdef ENABLE_BACKLASH_COMPENSATION
+      if (!st.exec_block->is_backlash_motion) {
+    #endif
     if (st.exec_block->direction_bits & (1<<Y_DIRECTION_BIT)) { sys.position[Y_AXIS]--; }
     else { sys.position[Y_AXIS]++; }
+    #ifdef ENABLE_BACKLASH_COMPENSATION
+      }
+    #endif
   }
   #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
     st.counter_z += st.steps[Z_AXIS];
@@ -365,12 +499,33 @@ ISR(TIMER1_COMPA_vect)
   if (st.counter_z > st.exec_block->step_event_count) {
     st.step_outbits |= (1<<Z_STEP_BIT);
     st.counter_z -= st.exec_block->step_event_count;
+    #ifdef ENABLE_BACKLASH_COMPENSATION
+      if (!st.exec_block->is_backlash_motion) {
+    #endif
     if (st.exec_block->direction_bits & (1<<Z_DIRECTION_BIT)) { sys.position[Z_AXIS]--; }
     else { sys.position[Z_AXIS]++; }
+    #ifdef ENABLE_BACKLASH_COMPENSATION
+      }
+    #endif
   }  
 
+  if (probe_armed) {
+    probe_position_lock = false;
+    if (sys_probe_state == PROBE_DEFERRED) { probe_latch_position(); }
+  }
+
+  #ifdef ENABLE_DUAL_AXIS
+    st.step_outbits_dual = 0;
+    if (st.step_outbits & DUAL_AXIS_STEP_MASK) { st.step_outbits_dual = DUAL_STEP_MASK; }
+  #endif
+
   // During a homing cycle, lock out and prevent desired axes from moving.
-  if (sys.state == STATE_HOMING) { st.step_outbits &= sys.homing_axis_lock; }   
+  if (sys.state == STATE_HOMING) { 
+    st.step_outbits &= sys.homing_axis_lock; 
+    #ifdef ENABLE_DUAL_AXIS
+      if (!sys.homing_axis_lock_dual) { st.step_outbits_dual = 0; }
+    #endif
+  }   
 
   st.step_count--; // Decrement step events count 
   if (st.step_count == 0) {
@@ -380,6 +535,9 @@ ISR(TIMER1_COMPA_vect)
   }
 
   st.step_outbits ^= step_port_invert_mask;  // Apply step port invert mask    
+  #ifdef ENABLE_DUAL_AXIS
+    st.step_outbits_dual ^= step_port_invert_mask_dual;
+  #endif
   busy = false;
 // SPINDLE_ENABLE_PORT ^= 1<<SPINDLE_ENABLE_BIT; // Debug: Used to time ISR
 }
@@ -400,6 +558,9 @@ ISR(TIMER0_OVF_vect)
 {
   // Reset stepping pins (leave the direction pins)
   STEP_PORT = (STEP_PORT & ~STEP_MASK) | (step_port_invert_mask & STEP_MASK); 
+  #ifdef ENABLE_DUAL_AXIS
+    DUAL_STEP_PORT = (DUAL_STEP_PORT & ~DUAL_STEP_MASK) | step_port_invert_mask_dual;
+  #endif
   TCCR0B = 0; // Disable Timer0 to prevent re-entering this interrupt when it's not needed. 
 }
 #ifdef STEP_PULSE_DELAY
@@ -411,6 +572,47 @@ ISR(TIMER0_OVF_vect)
   ISR(TIMER0_COMPA_vect) 
   { 
     STEP_PORT = st.step_bits; // Begin step pulse.
+    #ifdef ENABLE_DUAL_AXIS
+      DUAL_STEP_PORT = st.step_bits_dual;
+    #endif
+  }
+#endif
+
+
+#ifdef HOMING_CONCURRENT_AXES
+  void st_homing_start()
+  {
+    memset(&homing, 0, sizeof(st_homing_t));
+    uint8_t idx;
+    for (idx=0; idx<N_AXIS; idx++) {
+      homing.step_bits[idx] = get_step_pin_mask(idx);
+      homing.dir_bits[idx] = get_direction_pin_mask(idx);
+    }
+    st.homing = true;
+    // Run the ISR at the fixed homing rate, without a prescaler.
+    TCCR1B = (TCCR1B & ~(0x07<<CS10)) | (1<<CS10);
+    OCR1A = (F_CPU/HOMING_ISR_FREQUENCY)-1;
+    TCNT1 = 0;
+    st_wake_up();
+  }
+
+
+  void st_homing_set_rate(uint8_t axis, float step_rate, uint8_t reverse)
+  {
+    uint16_t rate = 0xFFFF; // Capped at one step per ISR tick.
+    if (step_rate < HOMING_ISR_FREQUENCY) { rate = step_rate*(65536.0/HOMING_ISR_FREQUENCY); }
+    uint8_t sreg = SREG;
+    cli();
+    homing.rate[axis] = rate;
+    if (reverse) { homing.reverse |= bit(axis); }
+    else { homing.reverse &= ~bit(axis); }
+    uint8_t dir_outbits = 0;
+    uint8_t idx;
+    for (idx=0; idx<N_AXIS; idx++) {
+      if (homing.reverse & bit(idx)) { dir_outbits |= homing.dir_bits[idx]; }
+    }
+    st.dir_outbits = dir_outbits ^ dir_port_invert_mask; // Output at the start of the next ISR tick.
+    SREG = sreg;
   }
 #endif
 
@@ -418,6 +620,7 @@ ISR(TIMER0_OVF_vect)
 // Generates the step and direction port invert masks used in the Stepper Interrupt Driver.
 void st_generate_step_dir_invert_masks()
 {  
+  #ifndef FIXED_MACHINE_PROFILE
   uint8_t idx;
   step_port_invert_mask = 0;
   dir_port_invert_mask = 0;
@@ -425,7 +628,27 @@ void st_generate_step_dir_invert_masks()
     if (bit_istrue(settings.step_invert_mask,bit(idx))) { step_port_invert_mask |= get_step_pin_mask(idx); }
     if (bit_istrue(settings.dir_invert_mask,bit(idx))) { dir_port_invert_mask |= get_direction_pin_mask(idx); }
   }
+  #ifdef ENABLE_DUAL_AXIS
+    // The second motor shares the step invert setting of its axis.
+    step_port_invert_mask_dual = 0;
+    if (bit_istrue(settings.step_invert_mask,bit(DUAL_AXIS_SELECT))) { step_port_invert_mask_dual = DUAL_STEP_MASK; }
+  #endif
+  #endif
+}
+
+
+#ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+// Converts the AMASS cutoff frequency settings into CPU cycles per step, so the segment generator
+// selects the AMASS level by integer comparison. Levels above settings.amass_max_level are not read.
+void st_update_amass_cutoffs()
+{
+  uint8_t idx;
+  for (idx=0; idx<MAX_AMASS_LEVEL; idx++) {
+    if (settings.amass_cutoff_freq[idx]) { amass_cutoff_cycles[idx] = F_CPU/settings.amass_cutoff_freq[idx]; }
+    else { amass_cutoff_cycles[idx] = 0xffffffff; }
+  }
 }
+#endif
 
 
 // Reset and clear stepper subsystem variables
@@ -448,6 +671,9 @@ void st_reset()
       
   // Initialize step and direction port pins.
   STEP_PORT = (STEP_PORT & ~STEP_MASK) | step_port_invert_mask;
+  #ifdef ENABLE_DUAL_AXIS
+    DUAL_STEP_PORT = (DUAL_STEP_PORT & ~DUAL_STEP_MASK) | step_port_invert_mask_dual;
+  #endif
   DIRECTION_PORT = (DIRECTION_PORT & ~DIRECTION_MASK) | dir_port_invert_mask;
 }
 
@@ -457,6 +683,9 @@ void stepper_init()
 {
   // Configure step and direction interface pins
   STEP_DDR |= STEP_MASK;
+  #ifdef ENABLE_DUAL_AXIS
+    DUAL_STEP_DDR |= DUAL_STEP_MASK;
+  #endif
   STEPPERS_DISABLE_DDR |= 1<<STEPPERS_DISABLE_BIT;
   DIRECTION_DDR |= DIRECTION_MASK;
 
@@ -511,6 +740,16 @@ void st_prep_buffer()
     if (prep.current_speed == 0.0) { return; } // Nothing to do. Bail.
   }
   
+  #ifdef ENABLE_PERFORMANCE_COUNTERS
+    // Track the segment buffer low-water mark. Only while a planner block is still queued, since
+    // the buffer always drains at the end of a motion.
+    if ((sys.state == STATE_CYCLE) && (plan_get_current_block() != NULL)) {
+      uint8_t segment_count = segment_buffer_head - segment_buffer_tail;
+      if (segment_count >= SEGMENT_BUFFER_SIZE) { segment_count += SEGMENT_BUFFER_SIZE; } // Wrapped
+      if (segment_count < perf.segment_low_water) { perf.segment_low_water = segment_count; }
+    }
+  #endif
+
   while (segment_buffer_tail != segment_next_head) { // Check if we need to fill the buffer.
 
     // Determine if we need to load a new planner block or if the block has been replanned. 
@@ -531,6 +770,16 @@ void st_prep_buffer()
         // segment buffer finishes the prepped block, but the stepper ISR is still executing it. 
         st_prep_block = &st_block_buffer[prep.st_block_index];
         st_prep_block->direction_bits = pl_block->direction_bits;
+        #ifdef ENABLE_BACKLASH_COMPENSATION
+          st_prep_block->is_backlash_motion = pl_block->is_backlash_motion;
+        #endif
+        st_prep_block->outputs = pl_block->outputs;
+        st_prep_block->spindle_pwm = pl_block->spindle_pwm;
+        #ifdef VARIABLE_SPINDLE
+          if ((pl_block->outputs & PL_OUTPUT_SYNC) || bit_istrue(settings.spindle_flags,BITFLAG_LASER_MODE)) {
+            st_prep_block->outputs |= ST_OUTPUT_PWM;
+          }
+        #endif
         #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
           st_prep_block->steps[X_AXIS] = pl_block->steps[X_AXIS];
           st_prep_block->steps[Y_AXIS] = pl_block->steps[Y_AXIS];
@@ -550,6 +799,12 @@ void st_prep_buffer()
         prep.steps_remaining = pl_block->step_event_count;
         prep.step_per_mm = prep.steps_remaining/pl_block->millimeters;
         prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR/prep.step_per_mm;
+        #ifdef REPORT_REALTIME_RATE
+          st_prep_block->rate_cycles = (TICKS_PER_MICROSECOND*1000000*60)/prep.step_per_mm;
+        #endif
+        #ifdef USE_LINE_NUMBERS
+          st_prep_block->line_number = pl_block->line_number;
+        #endif
         
         prep.dt_remainder = 0.0; // Reset for new planner block
 
@@ -559,6 +814,14 @@ void st_prep_buffer()
           pl_block->entry_speed_sqr = prep.exit_speed*prep.exit_speed; 
         }
         else { prep.current_speed = sqrt(pl_block->entry_speed_sqr); }
+
+        #ifdef VARIABLE_SPINDLE
+          // In laser mode, the laser power is scaled by the segment speed over the block nominal speed,
+          // so the power density stays constant through accelerations, decelerations, and feed holds.
+          if (bit_istrue(settings.spindle_flags,BITFLAG_LASER_MODE)) {
+            prep.laser_pwm_per_speed = st_prep_block->spindle_pwm/sqrt(pl_block->nominal_speed_sqr);
+          }
+        #endif
       }
      
       /* --------------------------------------------------------------------------------- 
@@ -758,11 +1021,10 @@ void st_prep_buffer()
     #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING        
       // Compute step timing and multi-axis smoothing level.
       // NOTE: AMASS overdrives the timer with each level, so only one prescalar is required.
-      if (cycles < AMASS_LEVEL1) { prep_segment->amass_level = 0; }
-      else {
-        if (cycles < AMASS_LEVEL2) { prep_segment->amass_level = 1; }
-        else if (cycles < AMASS_LEVEL3) { prep_segment->amass_level = 2; }
-        else { prep_segment->amass_level = 3; }    
+      prep_segment->amass_level = 0;
+      while ((prep_segment->amass_level < settings.amass_max_level) && 
+             (cycles >= amass_cutoff_cycles[prep_segment->amass_level])) { prep_segment->amass_level++; }
+      if (prep_segment->amass_level) {
         cycles >>= prep_segment->amass_level; 
         prep_segment->n_step <<= prep_segment->amass_level;
       }
@@ -786,6 +1048,17 @@ void st_prep_buffer()
       }
     #endif
 
+    #ifdef VARIABLE_SPINDLE
+      // Set the segment spindle PWM. In laser mode, scale it by the speed at the end of the segment.
+      if (bit_istrue(settings.spindle_flags,BITFLAG_LASER_MODE)) {
+        float laser_pwm = prep.current_speed*prep.laser_pwm_per_speed;
+        if (laser_pwm < st_prep_block->spindle_pwm) { prep_segment->spindle_pwm = laser_pwm; }
+        else { prep_segment->spindle_pwm = st_prep_block->spindle_pwm; }
+      } else {
+        prep_segment->spindle_pwm = st_prep_block->spindle_pwm;
+      }
+    #endif
+
     // Segment complete! Increment segment buffer indices.
     segment_buffer_head = segment_next_head;
     if ( ++segment_next_head == SEGMENT_BUFFER_SIZE ) { segment_next_head = 0; }
@@ -818,16 +1091,47 @@ void st_prep_buffer()
 }      
 
 
-// Called by realtime status reporting to fetch the current speed being executed. This value
-// however is not exactly the current speed, but the speed computed in the last step segment
-// in the segment buffer. It will always be behind by up to the number of segment blocks (-1)
-// divided by the ACCELERATION TICKS PER SECOND in seconds. 
+// Called by realtime status reporting to fetch the current speed being executed. Computed from
+// the step timing of the segment the stepper ISR is executing, i.e. its CPU cycles per step, and 
+// the step per mm scalar of its block. Zero when no segment is executing.
 #ifdef REPORT_REALTIME_RATE
   float st_get_realtime_rate()
   {
-     if (sys.state & (STATE_CYCLE | STATE_HOMING | STATE_HOLD | STATE_MOTION_CANCEL | STATE_SAFETY_DOOR)){
-       return prep.current_speed;
-     }
-    return 0.0f;
+    uint8_t sreg = SREG;
+    cli(); // Snapshot the executing segment and block, since the stepper ISR may switch them.
+    if (st.exec_segment == NULL) { 
+      SREG = sreg;
+      return(0.0); 
+    }
+    uint32_t cycles = st.exec_segment->cycles_per_tick;
+    #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+      cycles <<= st.exec_segment->amass_level; // AMASS overdrives the ISR by 2^level ticks per step.
+    #else
+      if (st.exec_segment->prescaler == 2) { cycles <<= 3; } // prescaler: 8
+      else if (st.exec_segment->prescaler == 3) { cycles <<= 6; } // prescaler: 64
+    #endif
+    float rate_cycles = st.exec_block->rate_cycles;
+    SREG = sreg;
+    return(rate_cycles/cycles);
+  }
+#endif
+
+
+// Called by realtime status reporting to fetch the line number of the block being executed. Falls 
+// back to the current planner block, i.e. a held block, when no segment is executing.
+#ifdef USE_LINE_NUMBERS
+  int32_t st_get_line_number()
+  {
+    uint8_t sreg = SREG;
+    cli();
+    if (st.exec_segment != NULL) {
+      int32_t line_number = st.exec_block->line_number;
+      SREG = sreg;
+      return(line_number);
+    }
+    SREG = sreg;
+    plan_block_t *pb = plan_get_current_block();
+    if (pb != NULL) { return(pb->line_number); }
+    return(0);
   }
 #endif
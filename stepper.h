@@ -19,8 +19,22 @@ void st_go_idle();
 // Generate the step and direction port invert masks.
 void st_generate_step_dir_invert_masks();
 
+// Regenerate the AMASS level cutoffs in CPU cycles from the AMASS settings.
+#ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+void st_update_amass_cutoffs();
+#endif
+
 // Reset the stepper subsystem variables       
 void st_reset();
+
+#ifdef HOMING_CONCURRENT_AXES
+  // Starts the stepper ISR as the homing step generator. Every axis is stopped until given a rate
+  // by st_homing_set_rate(). Ended by st_reset().
+  void st_homing_start();
+
+  // Sets the step rate (steps/sec) and direction of one axis of the homing step generator.
+  void st_homing_set_rate(uint8_t axis, float step_rate, uint8_t reverse);
+#endif
              
 // Reloads step segment buffer. Called continuously by realtime execution system.
 void st_prep_buffer();
@@ -33,4 +47,9 @@ void st_update_plan_block_parameters();
 float st_get_realtime_rate();
 #endif
 
+// Called by realtime status reporting if line numbers are enabled in config.h.
+#ifdef USE_LINE_NUMBERS
+int32_t st_get_line_number();
+#endif
+
 #endif
@@ -4,6 +4,9 @@
 #include "grbl.h"
 
 
+static uint8_t control_pin_state; // Control pin states at the last pin change interrupt.
+
+
 void system_init() 
 {
   CONTROL_DDR &= ~(CONTROL_MASK); //    
@@ -13,7 +16,98 @@ void system_init()
     CONTROL_PORT |= CONTROL_MASK;   // Enable internal pull-up resistors. Normal high operation.
   #endif
   CONTROL_PCMSK |= CONTROL_MASK;  // Enable specific pins of the Pin Change Interrupt
+  control_pin_state = CONTROL_PIN & CONTROL_MASK;
   PCICR |= (1 << CONTROL_INT);   // Enable Pin Change Interrupt
+
+  // Configure Timer2 as the free-running millisecond tick, counted from its overflow interrupt.
+  // NOTE: On the Uno, Timer2 also drives the variable spindle PWM. The spindle sets the same 1/8
+  // prescaler and 8-bit period, so enabling the spindle PWM does not alter the tick rate.
+  TCCR2A = (1<<WGM21) | (1<<WGM20); // Fast PWM mode. Outputs disconnected until the spindle enables them.
+  TCCR2B = (1<<CS21); // 1/8 prescaler
+  TIMSK2 |= (1<<TOIE2); // Enable Timer2 overflow interrupt
+
+  #ifdef ENABLE_PERFORMANCE_COUNTERS
+    system_clear_perf_counters();
+  #endif
+}
+
+
+// Millisecond tick. Timer2 overflows every TICK_OVERFLOW_US microseconds (128us at 16MHz, 7.8kHz),
+// which are accumulated here into whole milliseconds. The rate is fixed by the spindle PWM sharing
+// Timer2, and the overflow vector has priority over the stepper's TIMER1_COMPA, so the ISR only does
+// a 16-bit add and compare, plus a 32-bit increment once per millisecond. It reads no settings; 
+// anything periodic, like the status push, polls system_get_tick_ms() from the main loop instead.
+// Estimated from the instruction sequence at roughly 50 cycles (~3us) including prologue and 
+// epilogue, about 2.5% of the CPU, and the most a step interrupt can be held off by it.
+#define TICK_OVERFLOW_US ((uint16_t)((256UL*8UL*1000000UL)/F_CPU))
+static volatile uint32_t sys_tick_ms;
+static uint16_t sys_tick_us;
+
+#ifdef ENABLE_PERFORMANCE_COUNTERS
+  perf_counters_t perf;
+#endif
+
+ISR(TIMER2_OVF_vect)
+{
+  sys_tick_us += TICK_OVERFLOW_US;
+  if (sys_tick_us >= 1000) {
+    sys_tick_us -= 1000;
+    sys_tick_ms++;
+  }
+}
+
+
+uint32_t system_get_tick_ms()
+{
+  uint8_t sreg = SREG;
+  cli();
+  uint32_t tick_ms = sys_tick_ms;
+  SREG = sreg;
+  return(tick_ms);
+}
+
+
+#ifdef ENABLE_SPINDLE_SYNC
+// Microsecond tick, with the sub-overflow time read from the Timer2 count. Wraps around after roughly 
+// 71 minutes, so only intervals are meaningful. Safe to call from an interrupt.
+#define TICK_COUNTS_PER_US (F_CPU/8000000UL)
+uint32_t system_get_tick_us()
+{
+  uint8_t sreg = SREG;
+  cli();
+  uint8_t count = TCNT2;
+  uint32_t tick_us = sys_tick_ms*1000 + sys_tick_us;
+  if ((TIFR2 & (1<<TOV2)) && (count < 128)) { tick_us += TICK_OVERFLOW_US; } // Overflow not yet serviced.
+  SREG = sreg;
+  return(tick_us + count/TICK_COUNTS_PER_US);
+}
+#endif
+
+
+#ifdef ENABLE_PERFORMANCE_COUNTERS
+// Clears the performance counters. The segment low-water mark restarts from a full buffer.
+void system_clear_perf_counters()
+{
+  memset(&perf, 0, sizeof(perf_counters_t));
+  perf.segment_low_water = SEGMENT_BUFFER_SIZE;
+}
+#endif
+
+
+// Sets a delay deadline relative to now. If other delays are already pending, the latest deadline
+// is kept, so all pending delays complete together once the longest one has elapsed.
+void system_set_delay(uint8_t delay_flag, uint32_t milliseconds)
+{
+  uint32_t deadline = system_get_tick_ms() + milliseconds;
+  if (!(sys.delay) || ((int32_t)(deadline - sys.delay_deadline) > 0)) { sys.delay_deadline = deadline; }
+  sys.delay |= delay_flag;
+}
+
+
+// Wrap-around safe deadline comparison against the millisecond tick.
+uint8_t system_check_delay_elapsed()
+{
+  return((int32_t)(system_get_tick_ms() - sys.delay_deadline) >= 0);
 }
 
 /*
@@ -28,10 +122,19 @@ void system_init()
 //        .
 ISR(CONTROL_INT_vect) 
 {
+  probe_state_monitor(); // Probe pin shares this interrupt while armed. Latches the probe position first.
+  #ifdef ENABLE_SPINDLE_SYNC
+    spindle_index_capture(); // Index input shares this interrupt. Ignores changes on other pins.
+  #endif
   uint8_t pin = (CONTROL_PIN & CONTROL_MASK);
+  uint8_t pin_change = pin ^ control_pin_state;
+  control_pin_state = pin;
   #ifndef INVERT_ALL_CONTROL_PINS
     pin ^= CONTROL_INVERT_MASK;
   #endif
+  // Act only on control pins that just became active. The probe and spindle index inputs share this 
+  // interrupt, and must not re-issue a command for a control input that is held down.
+  pin &= pin_change;
   // ,     CONTROL   .
   if (pin) { 
     if (bit_istrue(pin,bit(RESET_BIT))) {
@@ -109,7 +212,7 @@ uint8_t system_execute_line(char *line)
       if ( line[(char_counter+1)] != 0 ) { return(STATUS_INVALID_STATEMENT); }
       switch( line[char_counter] ) {
         case '$' : //   Grbl 
-          if ( sys.state & (STATE_CYCLE | STATE_HOLD) ) { return(STATUS_IDLE_ERROR); } // Block during cycle. Takes too long to print.
+          if ( sys.state & (STATE_CYCLE | STATE_HOLD | STATE_JOG) ) { return(STATUS_IDLE_ERROR); } // Block during cycle. Takes too long to print.
           else { report_grbl_settings(); }
           break;
         case 'G' : //    gcode
@@ -140,22 +243,31 @@ uint8_t system_execute_line(char *line)
             }
           } // Otherwise, no effect.
           break;                   
-    //  case 'J' : break;  // Jogging methods
-          // TODO: Here jogging can be placed for execution as a seperate subprogram. It does not need to be 
-          // susceptible to other realtime commands except for e-stop. The jogging function is intended to
-          // be a basic toggle on/off with controlled acceleration and deceleration to prevent skipped 
-          // steps. The user would supply the desired feedrate, axis to move, and direction. Toggle on would
-          // start motion and toggle off would initiate a deceleration to stop. One could 'feather' the
-          // motion by repeatedly toggling to slow the motion to the desired location. Location data would 
-          // need to be updated real-time and supplied to the user through status queries.
-          //   More controlled exact motions can be taken care of by inputting G0 or G1 commands, which are 
-          // handled by the planner. It would be possible for the jog subprogram to insert blocks into the
-          // block buffer without having the planner plan them. It would need to manage de/ac-celerations 
-          // on its own carefully. This approach could be effective and possibly size/memory efficient.  
-//       }
-//       break;
       }
       break;
+    #ifdef REPORT_FORMAT_BENCHMARK
+      case 'B' : // Benchmark position formatting [ANY]
+        if ( line[++char_counter] != 0 ) { return(STATUS_INVALID_STATEMENT); }
+        else {
+          int32_t position[N_AXIS]; // Snapshot, so both formats see the same position.
+          memcpy(position,sys.position,sizeof(sys.position));
+          for (helper_var=0; helper_var<N_AXIS; helper_var++) { printBenchmarkCoordValue(position, helper_var); }
+        }
+        break;
+    #endif
+    #ifdef ENABLE_PERFORMANCE_COUNTERS
+      case 'P' : // Print or clear performance counters [ANY]
+        if ( line[++char_counter] == 0 ) { report_perf_counters(); }
+        else if ( (line[char_counter] == 'C') && (line[char_counter+1] == 0) ) { system_clear_perf_counters(); }
+        else { return(STATUS_INVALID_STATEMENT); }
+        break;
+    #endif
+    case 'J' : // Jogging [IDLE/JOG]
+      // Execute only if in IDLE or JOG states. Jogs sent while jogging are appended to the motion.
+      // NOTE: Also blocked during a dwell, since a jog starts immediately and would not wait for it.
+      if ( !(sys.state == STATE_IDLE || sys.state == STATE_JOG) || sys.delay ) { return(STATUS_IDLE_ERROR); }
+      if ( line[(char_counter+1)] != '=' ) { return(STATUS_INVALID_STATEMENT); }
+      return(gc_execute_line(line)); // NOTE: $J= is parsed by the g-code parser as a jog block.
     default : 
       // Block any system command that requires the state as IDLE/ALARM. (i.e. EEPROM, homing)
       if ( !(sys.state == STATE_IDLE || sys.state == STATE_ALARM) ) { return(STATUS_IDLE_ERROR); }
@@ -197,6 +309,26 @@ uint8_t system_execute_line(char *line)
             settings_store_build_info(line);
           }
           break; 
+        #ifdef ENABLE_HEIGHT_MAP
+          case 'M' : // Print, clear, or probe height map [IDLE/ALARM]
+            if ( line[++char_counter] == 0 ) { report_height_map(); break; }
+            if ( line[char_counter] == 'C' ) {
+              if ( line[++char_counter] != 0 ) { return(STATUS_INVALID_STATEMENT); }
+              mc_height_map_clear();
+              break;
+            }
+            if ( line[char_counter++] != '=' ) { return(STATUS_INVALID_STATEMENT); }
+            if (sys.state != STATE_IDLE) { return(STATUS_IDLE_ERROR); } // Probe only when idle.
+            { 
+              float map_value[4]; // Area X and Y size, probe depth, and probe feed rate
+              for (helper_var=0; helper_var<4; helper_var++) {
+                if ( helper_var && (line[char_counter++] != ',') ) { return(STATUS_INVALID_STATEMENT); }
+                if ( !read_float(line, &char_counter, &map_value[helper_var]) ) { return(STATUS_BAD_NUMBER_FORMAT); }
+              }
+              if ( line[char_counter] != 0 ) { return(STATUS_INVALID_STATEMENT); }
+              return(mc_height_map_probe(map_value, map_value[2], map_value[3]));
+            }
+        #endif
         case 'R' : // Restore defaults [IDLE/ALARM]
           if (line[++char_counter] != 'S') { return(STATUS_INVALID_STATEMENT); }
           if (line[++char_counter] != 'T') { return(STATUS_INVALID_STATEMENT); }
@@ -261,14 +393,14 @@ float system_convert_axis_steps_to_mpos(int32_t *steps, uint8_t idx)
   float pos;
   #ifdef COREXY
     if (idx==X_AXIS) { 
-      pos = (float)system_convert_corexy_to_x_axis_steps(steps) / settings.steps_per_mm[A_MOTOR];
+      pos = (float)system_convert_corexy_to_x_axis_steps(steps) * settings_inverse.mm_per_step[A_MOTOR];
     } else if (idx==Y_AXIS) {
-      pos = (float)system_convert_corexy_to_y_axis_steps(steps) / settings.steps_per_mm[B_MOTOR];
+      pos = (float)system_convert_corexy_to_y_axis_steps(steps) * settings_inverse.mm_per_step[B_MOTOR];
     } else {
-      pos = steps[idx]/settings.steps_per_mm[idx];
+      pos = steps[idx]*settings_inverse.mm_per_step[idx];
     }
   #else
-    pos = steps[idx]/settings.steps_per_mm[idx];
+    pos = steps[idx]*settings_inverse.mm_per_step[idx];
   #endif
   return(pos);
 }
@@ -284,6 +416,57 @@ void system_convert_array_steps_to_mpos(float *position, int32_t *steps)
 }
 
 
+// Returns the position of axis 'idx' in reported units, the last printed digit of a coordinate, less
+// a work 'offset' in reported units, 24.8 fixed-point. Must be sent a 'step' array. Integer-only, by 
+// the fixed-point scale factors in settings_inverse and gc_state.work_offset. The 32-bit fraction is 
+// multiplied in 16-bit partial products, which the AVR hardware multiplier handles directly. The 
+// offset is taken off in 16.16 fixed-point and the difference rounded once, half away from zero like 
+// printFloat().
+int32_t system_convert_axis_steps_to_coord_units(int32_t *steps, uint8_t idx, int32_t offset)
+{
+  int32_t axis_steps;
+  #ifdef COREXY
+    if (idx==X_AXIS) { axis_steps = system_convert_corexy_to_x_axis_steps(steps); }
+    else if (idx==Y_AXIS) { axis_steps = system_convert_corexy_to_y_axis_steps(steps); }
+    else { axis_steps = steps[idx]; }
+  #else
+    axis_steps = steps[idx];
+  #endif
+  uint32_t n = axis_steps;
+  if (axis_steps < 0) { n = -n; }
+  uint16_t n_hi = n >> 16;
+  uint16_t n_lo = n;
+  uint16_t frac_hi = settings_inverse.coord_units_per_step_frac[idx] >> 16;
+  uint16_t frac_lo = settings_inverse.coord_units_per_step_frac[idx];
+  uint32_t hi_lo = (uint32_t)n_hi*frac_lo;
+  uint32_t lo_hi = (uint32_t)n_lo*frac_hi;
+  uint32_t carry = (hi_lo & 0xffff) + (lo_hi & 0xffff) + (((uint32_t)n_lo*frac_lo) >> 16);
+  int32_t whole = n*settings_inverse.coord_units_per_step_int[idx] + (uint32_t)n_hi*frac_hi + 
+                  (hi_lo >> 16) + (lo_hi >> 16) + (carry >> 16);
+  uint16_t fraction = carry;
+  
+  // Signed value is whole+fraction/65536, with the whole part floored.
+  if (axis_steps < 0) {
+    whole = -whole;
+    if (fraction) { whole--; fraction = -fraction; }
+  }
+  if (offset) {
+    int32_t offset_whole = offset >> 8; // Floored, by the arithmetic shift.
+    uint16_t offset_fraction = (uint16_t)(offset & 0xff) << 8;
+    if (fraction < offset_fraction) { whole--; } // Borrow
+    fraction -= offset_fraction;
+    whole -= offset_whole;
+  }
+
+  // Round the magnitude to the nearest unit.
+  if (whole < 0) {
+    if (fraction) { whole++; fraction = -fraction; } // Magnitude is -whole+fraction/65536.
+    return(whole - (fraction >= 0x8000));
+  }
+  return(whole + (fraction >= 0x8000));
+}
+
+
 // CoreXY calculation only. Returns x or y-axis "steps" based on CoreXY motor steps.
 #ifdef COREXY
   int32_t system_convert_corexy_to_x_axis_steps(int32_t *steps)
@@ -26,6 +26,7 @@
 #define EXEC_RESET          bit(4) // bitmask 00010000
 #define EXEC_SAFETY_DOOR    bit(5) // bitmask 00100000
 #define EXEC_MOTION_CANCEL  bit(6) // bitmask 01000000
+#define EXEC_BINARY_STATUS_REPORT bit(7) // bitmask 10000000
 
 // Alarm executor bit map.
 // NOTE: EXEC_CRITICAL_EVENT is an optional flag that must be set with an alarm flag. When enabled,
@@ -43,6 +44,7 @@
 #define EXEC_ALARM_ABORT_CYCLE  bit(3) // bitmask 00001000
 #define EXEC_ALARM_PROBE_FAIL   bit(4) // bitmask 00010000
 #define EXEC_ALARM_HOMING_FAIL  bit(5) // bitmask 00100000
+#define EXEC_ALARM_SPINDLE_SYNC bit(6) // bitmask 01000000
 
 // Define system state bit map. The state variable primarily tracks the individual functions
 // of Grbl to manage each without overlapping. It is also used as a messaging flag for
@@ -55,6 +57,7 @@
 #define STATE_HOLD          bit(4) //   
 #define STATE_SAFETY_DOOR   bit(5) //   .     .
 #define STATE_MOTION_CANCEL bit(6) //         .
+#define STATE_JOG           bit(7) // Jog motion from the $J= command. Cancelled, not held, by hold commands.
 
 //    .
 #define SUSPEND_DISABLE       0      //    .
@@ -62,6 +65,15 @@
 #define SUSPEND_ENABLE_READY  bit(1) //       .
 #define SUSPEND_ENERGIZE      bit(2) //     .
 #define SUSPEND_MOTION_CANCEL bit(3) //   .   .
+#define SUSPEND_JOG_CANCEL    bit(4) // Jog cancel. Discards remaining jog motions once stopped.
+
+
+// Define non-blocking delay bitflags. Delays are timed against the millisecond tick and polled by
+// the main program, so the realtime commands and status reports remain responsive while waiting.
+#define DELAY_NONE          0
+#define DELAY_DWELL         bit(0) // G4 dwell. Blocks cycle start and buffer synchronization.
+#define DELAY_DOOR_RESTORE  bit(1) // Spindle and coolant power-up after a safety door resume.
+#define DELAY_SPINDLE_INDEX bit(2) // G33 index pulse wait. Blocks cycle start. Cleared by the wait, not a deadline.
 
 
 //    
@@ -69,7 +81,8 @@ typedef struct {
   uint8_t abort;                 //   .       .
   uint8_t state;                 //    Grbl.
   uint8_t suspend;               //    bitflag,   ,    .
-  uint8_t soft_limit;            //       . (boolean)
+  uint8_t soft_limit;            // Flags a motion rejected by soft limits, for the g-code parser to report. (boolean)
+  uint8_t jog_cancel_count;      // Counts completed jog cancels, so a jog waiting on a full planner can tell.
   
   int32_t position[N_AXIS];      //       (  ) .
                                  // :   ,    ,   .                         
@@ -77,6 +90,11 @@ typedef struct {
   int32_t probe_position[N_AXIS]; //        .
   uint8_t probe_succeeded;        // ,      .
   uint8_t homing_axis_lock;       //     .         ISR.
+  #ifdef ENABLE_DUAL_AXIS
+    uint8_t homing_axis_lock_dual; // Homing lock of the dual axis second motor. True while it may move.
+  #endif
+  uint8_t delay;                  // Tracks pending non-blocking delays. See DELAY bitflags.
+  uint32_t delay_deadline;        // Millisecond tick at which the pending delays are complete.
 } system_t;
 extern system_t sys;
 
@@ -84,6 +102,19 @@ volatile uint8_t sys_probe_state;    // 
 volatile uint8_t sys_rt_exec_state;  //   bitflag      . .   EXEC.
 volatile uint8_t sys_rt_exec_alarm;  //   bitflag        .
 
+#ifdef ENABLE_PERFORMANCE_COUNTERS
+  // Performance counters. Reported by '$P' and cleared by '$PC'.
+  typedef struct {
+    uint32_t planner_underrun;   // Cycles ended by an empty planner with serial input still pending.
+    uint32_t planner_full_ms;    // Milliseconds spent waiting on a full planner buffer.
+    uint32_t recalculate_count;  // Planner recalculate passes.
+    uint32_t recalculate_blocks; // Blocks touched by the planner recalculate passes.
+    uint32_t junction_limited;   // Blocks with the entry speed limited by the junction deviation.
+    uint8_t segment_low_water;   // Fewest queued step segments seen with a planner block pending.
+  } perf_counters_t;
+  extern perf_counters_t perf;
+#endif
+
 
 //   
 void system_init();
@@ -94,6 +125,23 @@ uint8_t system_check_safety_door_ajar();
 //    ,   ,    '$'
 uint8_t system_execute_line(char *line);
 
+// Returns the free-running millisecond tick count. Wraps around after roughly 49 days.
+uint32_t system_get_tick_ms();
+
+// Returns the free-running microsecond tick count, for timing spindle index pulses.
+uint32_t system_get_tick_us();
+
+#ifdef ENABLE_PERFORMANCE_COUNTERS
+  // Clears the performance counters.
+  void system_clear_perf_counters();
+#endif
+
+// Starts or extends a non-blocking delay, flagged by the given DELAY bitflag.
+void system_set_delay(uint8_t delay_flag, uint32_t milliseconds);
+
+// Returns true if the pending delays have elapsed. Does not clear the delay flags.
+uint8_t system_check_delay_elapsed();
+
 // Execute the startup script lines stored in EEPROM upon initialization
 void system_execute_startup(char *line);
 
@@ -103,6 +151,10 @@ float system_convert_axis_steps_to_mpos(int32_t *steps, uint8_t idx);
 // Updates a machine 'position' array based on the 'step' array sent.
 void system_convert_array_steps_to_mpos(float *position, int32_t *steps);
 
+// Returns position of axis 'idx' in reported units, the last printed digit, less a work 'offset' in mm.
+// Must be sent a 'step' array.
+int32_t system_convert_axis_steps_to_coord_units(int32_t *steps, uint8_t idx, int32_t offset);
+
 // CoreXY calculation only. Returns x or y-axis "steps" based on CoreXY motor steps.
 #ifdef COREXY
   int32_t system_convert_corexy_to_x_axis_steps(int32_t *steps);